@@ -2,21 +2,95 @@
 #include "cache/cache.hpp"
 #include "util/random.hpp"
 
+PageMap::PageMap(uint64_t page_size, bool random_map, RandomGen *rng, uint32_t addr_bits)
+  : page_bits(0), addr_bits(addr_bits), random_map(random_map),
+    rng(rng ? rng : default_random_gen()), next_vpn(0), next_pfn(0)
+{
+  while((2ull << page_bits) <= page_size) page_bits++;
+  clear();
+}
+
+void PageMap::clear() {
+  page_table.clear();
+  used_frames.clear();
+  next_vpn = 0;
+  if(!random_map) // start the consecutive frames from a random position
+    next_pfn = rng->uniform(1ull << (addr_bits - page_bits - 1));
+}
+
+uint64_t PageMap::alloc_page() {
+  return (next_vpn++) << page_bits;
+}
+
+uint64_t PageMap::translate(uint64_t vaddr) {
+  uint64_t vpn = vaddr >> page_bits;
+  auto it = page_table.find(vpn);
+  if(it == page_table.end()) {
+    uint64_t pfn;
+    if(random_map) {
+      do { pfn = rng->uniform(1ull << (addr_bits - page_bits)); } while(used_frames.count(pfn));
+      used_frames.insert(pfn);
+    } else
+      pfn = next_pfn++;
+    it = page_table.insert(std::make_pair(vpn, pfn)).first;
+  }
+  return (it->second << page_bits) | (vaddr & page_mask());
+}
+
+static void random_candidate_kernel(std::list<uint64_t>& candidate, uint32_t num, uint64_t target,
+                                    RandomGen *rng)
+{
+  get_random_list(candidate, num, 1ull << 60, rng);
+}
+
+candidate_gen_t random_candidate(RandomGen *rng)
+{
+  return std::bind(random_candidate_kernel, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+                   rng);
+}
+
+static void page_candidate_kernel(std::list<uint64_t>& candidate, uint32_t num, uint64_t target,
+                                  PageMap *pmap)
+{
+  uint64_t offset = CM::normalize(target) & pmap->page_mask();
+  for(uint32_t i=0; i<num; i++)
+    candidate.push_back(pmap->translate(pmap->alloc_page() | offset));
+}
+
+candidate_gen_t page_candidate(PageMap *pmap)
+{
+  return std::bind(page_candidate_kernel, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+                   pmap);
+}
+
 bool obtain_targeted_evict_set(
                                uint32_t num,
                                std::list<uint64_t>& candidate,
                                L1CacheBase * cache,
                                uint64_t target,
                                traverse_test_t traverse,
-                               uint32_t trial
+                               uint32_t trial,
+                               candidate_gen_t gen
                                )
 {
   for(int i=0; trial==0 || i<trial; i++) {
     candidate.clear();
-    get_random_list(candidate, num, 1ull << 60);
+    gen(candidate, num, target);
     if(traverse(cache, candidate, target))
       return true;
   }
   return false;
 }
 
+bool obtain_targeted_evict_set(
+                               uint32_t num,
+                               std::list<uint64_t>& candidate,
+                               L1CacheBase * cache,
+                               uint64_t target,
+                               traverse_test_t traverse,
+                               uint32_t trial,
+                               RandomGen *rng
+                               )
+{
+  return obtain_targeted_evict_set(num, candidate, cache, target, traverse, trial, random_candidate(rng));
+}
@@ -2,6 +2,54 @@
 #define ATT_CREATE_HPP_
 
 #include "attack/traverse.hpp"
+#include "util/random.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+// virtual to physical page mapping of the attacker's memory
+//   pages are allocated on demand and mapped to either random or consecutive physical frames
+class PageMap
+{
+  uint32_t page_bits;   // 12 for 4K pages and 21 for 2M pages
+  uint32_t addr_bits;   // width of the physical address space
+  bool random_map;      // random frames or consecutive frames
+  RandomGen *rng;
+  uint64_t next_vpn;    // the next unallocated virtual page
+  uint64_t next_pfn;    // the next frame for consecutive mapping
+  std::unordered_map<uint64_t, uint64_t> page_table;  // vpn -> pfn
+  std::unordered_set<uint64_t> used_frames;
+
+public:
+  PageMap(uint64_t page_size, bool random_map, RandomGen *rng = NULL, uint32_t addr_bits = 60);
+
+  uint64_t page_size() const { return 1ull << page_bits; }
+  uint64_t page_mask() const { return page_size() - 1; }
+
+  uint64_t alloc_page();                 // allocate a new virtual page and return its base address
+  uint64_t translate(uint64_t vaddr);    // virtual to physical address
+  void clear();                          // release all pages, call between independent searches
+};
+
+// generate `num' candidate lines for evicting `target'
+typedef std::function<void(std::list<uint64_t>&, uint32_t, uint64_t)> candidate_gen_t;
+
+// lines drawn uniformly from the whole address space
+extern candidate_gen_t random_candidate(RandomGen *rng = NULL);
+
+// lines from newly allocated pages sharing the page offset of the target
+extern candidate_gen_t page_candidate(PageMap *pmap);
+
+extern bool
+obtain_targeted_evict_set
+(
+ uint32_t num,                      // number of lines to be generated
+ std::list<uint64_t>& candidate,    // the generated candidates
+ L1CacheBase * cache,               // the L1 cache that can be accessed
+ uint64_t target,                   // the target address to be evicted
+ traverse_test_t traverse,          // traverse function
+ uint32_t trial,                    // the maximal number of trials
+ candidate_gen_t gen                // candidate generator
+ );
 
 extern bool
 obtain_targeted_evict_set
@@ -11,7 +59,8 @@ obtain_targeted_evict_set
  L1CacheBase * cache,               // the L1 cache that can be accessed
  uint64_t target,                   // the target address to be evicted
  traverse_test_t traverse,          // traverse function
- uint32_t trial                     // the maximal number of trials
+ uint32_t trial,                    // the maximal number of trials
+ RandomGen *rng = NULL              // the random number generator
  );
 
 #endif
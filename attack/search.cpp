@@ -1,24 +1,18 @@
 #include "attack/search.hpp"
 #include "attack/create.hpp"
+#include "cache/cache.hpp"
 #include "util/random.hpp"
+#include <unordered_set>
+#include <algorithm>
 
 void split_random_set(
                       std::list<uint64_t> &candidate,
                       std::list<uint64_t> &picked_set,
-                      uint32_t pick
+                      uint32_t pick,
+                      RandomGen *rng
                       )
 {
-  std::unordered_set<uint32_t> picked_index;
-  get_random_set32(picked_index, pick, candidate.size()-1);
-  uint32_t i = 0;
-  auto it = candidate.begin();
-  for(uint32_t index = 0; index < candidate.size(); index++) {
-    if(picked_index.count(index)) {
-      picked_set.push_back(*it);
-      it = candidate.erase(it);
-    } else
-      it++;
-  }
+  split_random_list(candidate, picked_set, pick, rng);
 }
 
 bool targeted_evict_random_pick(
@@ -28,16 +22,18 @@ bool targeted_evict_random_pick(
                                 std::list<uint64_t> &picked_set,
                                 std::list<uint64_t> &evict_set,
                                 traverse_test_t traverse,
-                                uint32_t pick
+                                uint32_t pick,
+                                RandomGen *rng
                                 )
 {
-  split_random_set(candidate, picked_set, pick);
+  split_random_set(candidate, picked_set, pick, rng);
   std::list<uint64_t> traverse_set(candidate.cbegin(), candidate.cend());
   traverse_set.insert(traverse_set.end(), evict_set.cbegin(), evict_set.cend());
   return traverse(cache, traverse_set, target);
 }
 
-static uint32_t loop_size, loop_count, loop_count_max;
+// reset by every search, so a search does not inherit the guard state of the previous one on the thread
+static thread_local uint32_t loop_size, loop_count, loop_count_max;
 
 bool static loop_guard(uint32_t new_size) {
   if(loop_size == new_size) {
@@ -57,16 +53,21 @@ bool targeted_trim_original(
                             uint64_t target,
                             std::list<uint64_t> &candidate,
                             traverse_test_t traverse,
-                            check_func_t check
+                            check_func_t check,
+                            RandomGen *rng,
+                            bool rollback
                             )
 {
   std::list<uint64_t> picked_set, evict_set;
-  loop_count = 0;
+  loop_size = loop_count = 0;
+  if(rollback) cache->checkpoint();
   while(candidate.size() > 0 && loop_guard(candidate.size())) {
-    if(!targeted_evict_random_pick(cache, target, candidate, picked_set, evict_set, traverse, 1))
+    if(!targeted_evict_random_pick(cache, target, candidate, picked_set, evict_set, traverse, 1, rng))
       candidate.insert(candidate.end(), picked_set.begin(), picked_set.end());
     picked_set.clear();
+    if(rollback) cache->rollback();
   }
+  if(rollback) cache->discard_checkpoint();
   return check(candidate);
 }
 
@@ -76,23 +77,25 @@ bool targeted_trim_divide(
                           std::list<uint64_t> &candidate,
                           traverse_test_t traverse,
                           check_func_t check,
-                          uint32_t split
+                          uint32_t split,
+                          RandomGen *rng,
+                          bool rollback
                           )
 {
   std::list<uint64_t> picked_set, evict_set;
-  loop_count = 0;
+  loop_size = loop_count = 0;
   while(candidate.size() > 2*split && loop_guard(candidate.size())) {
     uint32_t step = (candidate.size() + split - 1) / split;
     for(uint32_t i=0; i<split; i++) {
       picked_set.clear();
-      if(targeted_evict_random_pick(cache, target, candidate, picked_set, evict_set, traverse, step))
+      if(targeted_evict_random_pick(cache, target, candidate, picked_set, evict_set, traverse, step, rng))
         break;
       evict_set.insert(evict_set.end(), picked_set.begin(), picked_set.end());
     }
     candidate.insert(candidate.end(), evict_set.begin(), evict_set.end());
     evict_set.clear();
   }
-  return targeted_trim_original(cache, target, candidate, traverse, check);
+  return targeted_trim_original(cache, target, candidate, traverse, check, rng, rollback);
 }
 
 bool targeted_trim_divide_random(
@@ -101,16 +104,83 @@ bool targeted_trim_divide_random(
                           std::list<uint64_t> &candidate,
                           traverse_test_t traverse,
                           check_func_t check,
-                          uint32_t split
+                          uint32_t split,
+                          RandomGen *rng,
+                          bool rollback
                           )
 {
   std::list<uint64_t> picked_set, evict_set;
-  loop_count = 0;
+  loop_size = loop_count = 0;
   while(candidate.size() > 2*split && loop_guard(candidate.size())) {
     uint32_t step = (candidate.size() + split - 1) / split;
     picked_set.clear();
-    if(!targeted_evict_random_pick(cache, target, candidate, picked_set, evict_set, traverse, step))
+    if(!targeted_evict_random_pick(cache, target, candidate, picked_set, evict_set, traverse, step, rng))
       candidate.insert(candidate.end(), picked_set.begin(), picked_set.end());
   }
-  return targeted_trim_original(cache, target, candidate, traverse, check);
+  return targeted_trim_original(cache, target, candidate, traverse, check, rng, rollback);
+}
+
+uint32_t targeted_bulk_search(
+                              L1CacheBase * cache,
+                              const std::vector<uint64_t> &targets,
+                              std::list<uint64_t> &pool,
+                              std::vector<std::list<uint64_t> > &evict_sets,
+                              traverse_gen_t traverse_gen,
+                              check_gen_t check_gen,
+                              hit_gen_t hit_gen,
+                              uint32_t split,
+                              RandomGen *rng
+                              )
+{
+  std::vector<uint32_t> classes;  // index of the targets owning a congruence class
+  uint32_t found = 0;
+  evict_sets.assign(targets.size(), std::list<uint64_t>());
+
+  for(uint32_t t=0; t<targets.size(); t++) {
+    uint64_t target = targets[t];
+    traverse_test_t traverse = traverse_gen(target);
+    check_func_t check = check_gen(target);
+
+    // reuse: the target may be congruent with a class already found
+    bool reused = false;
+    for(auto c : classes)
+      if(traverse(cache, evict_sets[c], target) && check(evict_sets[c])) {
+        evict_sets[t] = evict_sets[c];
+        reused = true;
+        break;
+      }
+    if(reused) { found++; continue; }
+
+    // trim a new eviction set from the remaining pool
+    if(!traverse(cache, pool, target)) continue;
+    std::list<uint64_t> candidate(pool);
+    if(!targeted_trim_divide_random(cache, target, candidate, traverse, check, split, rng))
+      continue;
+
+    // partition: move the lines congruent with the new eviction set out of the pool
+    //   the pool is tested in chunks of as many lines as the eviction set, which cannot fill a set by themselves:
+    //   the chunk is primed, the eviction set traversed once (by the test of the first line of the chunk)
+    //   and the lines of the chunk evicted are congruent with it
+    std::unordered_set<uint64_t> evset(candidate.begin(), candidate.end()), congruent;
+    std::vector<uint64_t> lines;
+    for(auto l : pool) if(!evset.count(l)) lines.push_back(l);
+    for(size_t i = 0; i < lines.size(); i += candidate.size()) {
+      size_t end = std::min(lines.size(), i + candidate.size());
+      for(size_t k = i + 1; k < end; k++) cache->read(lines[k]);
+      if(traverse_gen(lines[i])(cache, candidate, lines[i])) congruent.insert(lines[i]);
+      for(size_t k = i + 1; k < end; k++)
+        if(!hit_gen(lines[k])(lines[k])) congruent.insert(lines[k]);
+    }
+    for(auto it = pool.begin(); it != pool.end();) {
+      if(evset.count(*it) || congruent.count(*it))
+        it = pool.erase(it);
+      else
+        it++;
+    }
+
+    evict_sets[t] = candidate;
+    classes.push_back(t);
+    found++;
+  }
+  return found;
 }
@@ -2,17 +2,25 @@
 #define ATT_SEARCH_HPP_
 
 #include "attack/traverse.hpp"
+#include "util/random.hpp"
+#include <vector>
 
 class L1CacheBase;
 
 typedef std::function<bool(std::list<uint64_t>&)> check_func_t;
 
+// traverse and check functions bound to a specific target
+typedef std::function<traverse_test_t(uint64_t)> traverse_gen_t;
+typedef std::function<check_func_t(uint64_t)> check_gen_t;
+typedef std::function<hit_func_t(uint64_t)> hit_gen_t;
+
 extern void
 split_random_set
 (
  std::list<uint64_t> &candidate,    // potential lines for the eviction unordered_set
  std::list<uint64_t> &picked_set,   // the lines being picked
- uint32_t pick                      // number of lines to be picked
+ uint32_t pick,                     // number of lines to be picked
+ RandomGen *rng = NULL              // the random number generator
  );
 
 extern bool
@@ -24,7 +32,8 @@ targeted_evict_random_pick
  std::list<uint64_t> &picked_set,   // the lines being picked
  std::list<uint64_t> &evict_set,    // confirmed lines in the eviction set
  traverse_test_t traverse,          // traverse function
- uint32_t pick                      // the number of lines to be picked
+ uint32_t pick,                     // the number of lines to be picked
+ RandomGen *rng = NULL              // the random number generator
  );
 
 extern bool
@@ -34,7 +43,9 @@ targeted_trim_original
  uint64_t target,                   // the target address to be evicted
  std::list<uint64_t> &candidate,    // potential lines for the eviction set
  traverse_test_t traverse,          // traverse function
- check_func_t check                 // eviction set check function
+ check_func_t check,                // eviction set check function
+ RandomGen *rng = NULL,             // the random number generator
+ bool rollback = false              // run every test from the hierarchy state at entry (checkpoint/rollback)
  );
 
 extern bool
@@ -45,7 +56,9 @@ targeted_trim_divide
  std::list<uint64_t> &candidate,    // potential lines for the eviction set
  traverse_test_t traverse,          // traverse function
  check_func_t check,                // eviction set check function
- uint32_t split                     // number of split in each pass
+ uint32_t split,                    // number of split in each pass
+ RandomGen *rng = NULL,             // the random number generator
+ bool rollback = false              // roll back the tests of the final trim_original pass
  );
 
 extern bool
@@ -56,7 +69,25 @@ targeted_trim_divide_random
  std::list<uint64_t> &candidate,    // potential lines for the eviction set
  traverse_test_t traverse,          // traverse function
  check_func_t check,                // eviction set check function
- uint32_t split                     // number of split in each pass
+ uint32_t split,                    // number of split in each pass
+ RandomGen *rng = NULL,             // the random number generator
+ bool rollback = false              // roll back the tests of the final trim_original pass
+ );
+
+// find eviction sets for multiple targets from a shared candidate pool
+// return the number of targets with an eviction set found
+extern uint32_t
+targeted_bulk_search
+(
+ L1CacheBase * cache,               // the L1 cache that can be accessed
+ const std::vector<uint64_t> &targets, // the target addresses to be evicted
+ std::list<uint64_t> &pool,         // shared candidate pool, lines assigned to a congruence class are removed
+ std::vector<std::list<uint64_t> > &evict_sets, // the eviction set of each target, empty if not found
+ traverse_gen_t traverse_gen,       // generator of the traverse function of a target
+ check_gen_t check_gen,             // generator of the eviction set check function of a target
+ hit_gen_t hit_gen,                 // generator of the hit function of a line in the target cache level
+ uint32_t split,                    // number of split in each pass
+ RandomGen *rng = NULL              // the random number generator
  );
 
 #endif
@@ -85,3 +85,20 @@ traverse_test_t traverse_test(traverse_func_t traverse, hit_func_t hit,
                    std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
                    traverse, hit, ntests, ntraverse, threshold);
 }
+
+bool traverse_test_rollback_kernel(L1CacheBase *cache, const std::list<uint64_t>& evset, uint64_t target,
+                                   traverse_test_t test)
+{
+  cache->checkpoint();
+  bool rv = test(cache, evset, target);
+  cache->rollback();
+  cache->discard_checkpoint();
+  return rv;
+}
+
+traverse_test_t traverse_test_rollback(traverse_test_t test)
+{
+  return std::bind(traverse_test_rollback_kernel,
+                   std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+                   test);
+}
@@ -43,4 +43,10 @@ extern traverse_test_ratio_t traverse_test_ratio(traverse_func_t traverse, hit_f
 extern traverse_test_t traverse_test(traverse_func_t traverse, hit_func_t hit,
                                      uint32_t ntests, uint32_t ntraverse, uint32_t threshold);
 
+// run a traverse test from the current cache state and roll the hierarchy back afterwards
+bool traverse_test_rollback_kernel(L1CacheBase *cache, const std::list<uint64_t>& evset, uint64_t target,
+                                   traverse_test_t test);
+
+extern traverse_test_t traverse_test_rollback(traverse_test_t test);
+
 #endif
@@ -0,0 +1,77 @@
+#include "attack/trial.hpp"
+#include "attack/create.hpp"
+#include "attack/search.hpp"
+#include "cache/cache.hpp"
+#include "util/query.hpp"
+#include "util/report.hpp"
+#include "util/statistics.hpp"
+
+void eviction_trial(const CacheCFG &ccfg, const TraverseTestCFG &tcfg, traverse_func_t traverse_func,
+                    uint32_t cache_level, uint32_t candidate_size, uint32_t split, uint32_t testN,
+                    EvictionTrialResult *result, EvictionTrialPool *pool)
+{
+  std::vector<CoherentCache *> l1_caches, l2_caches;
+  build_hierarchy(ccfg, &l1_caches, &l2_caches);
+
+  RandomGen rng;
+  rng.seed(tcfg.seed);
+
+  MeanStat stat_mean_evict, stat_mean_full;
+  result->evict_dist.clear();
+  std::list<uint64_t> candidate;
+  L1CacheBase *entry = (L1CacheBase *)l1_caches[0];
+
+  PageMap *pmap = tcfg.page_size ? new PageMap(tcfg.page_size, tcfg.page_map == "random", &rng) : NULL;
+  candidate_gen_t candidate_gen = pmap ? page_candidate(pmap) : random_candidate(&rng);
+
+  for(uint32_t t=0; t<testN; t++) {
+    uint64_t target = get_random_uint64(1ull << 60, &rng);
+    candidate.clear();
+    if(pmap) pmap->clear();
+    reporter.clear();
+    if(cache_level == 1) reporter.register_cache_access_tracer(1, 0, 0);
+    else                 reporter.register_cache_access_tracer(2);
+
+    // hit and check functions on the cache of the target level
+    std::list<LocInfo> locs;
+    entry->query_loc(target, &locs);
+    auto loc = locs.begin();
+    for(int i=1; i<cache_level; i++) loc++;
+    CacheBase *c = loc->cache;
+    hit_func_t hit = std::bind(query_hit, std::placeholders::_1, c);
+    check_func_t check = std::bind(query_check, target, c, std::placeholders::_1);
+    traverse_test_t traverse = traverse_test(traverse_func, hit, tcfg.ntests, tcfg.ntraverse, tcfg.threshold);
+
+    if(!obtain_targeted_evict_set(candidate_size, candidate, entry, target, traverse, 1000, candidate_gen))
+      continue;
+
+    double creation_access = (cache_level == 1) ?
+      (double)(reporter.check_cache_access(1, 0, 0)) :
+      (double)(reporter.check_cache_access(2)) ;
+
+    if(!targeted_trim_divide_random(entry, target, candidate, traverse, check, split, &rng, tcfg.rollback))
+      continue;
+
+    double evict_access = (cache_level == 1) ?
+      (double)(reporter.check_cache_access(1, 0, 0)) :
+      (double)(reporter.check_cache_access(2)) ;
+
+    stat_mean_evict.record(evict_access - creation_access);
+    stat_mean_full.record(evict_access);
+    result->evict_dist.record(evict_access - creation_access);
+    if(pool) {
+      pool->evict.record(evict_access - creation_access);
+      pool->full.record(evict_access);
+    }
+  }
+
+  result->found = stat_mean_full.count();
+  result->full_mean = stat_mean_full.mean();
+  result->full_error = stat_mean_full.error();
+  result->evict_mean = stat_mean_evict.mean();
+  result->evict_error = stat_mean_evict.error();
+
+  reporter.clear();
+  delete pmap;
+  release_hierarchy(&l1_caches, &l2_caches);
+}
@@ -0,0 +1,40 @@
+#ifndef ATT_TRIAL_HPP_
+#define ATT_TRIAL_HPP_
+
+#include "util/cache_config_parser.hpp"
+#include "util/traverse_config_parser.hpp"
+#include "util/statistics.hpp"
+
+// accesses to the target cache level of repeated eviction set searches
+struct EvictionTrialResult {
+  uint32_t found;                    // searches that found an eviction set
+  double full_mean, full_error;      // creation and trim
+  double evict_mean, evict_error;    // trim only
+  QuantileSketch evict_dist;         // distribution of the trim-only accesses
+};
+
+// statistics of one search setup shared by trials running concurrently on multiple threads
+// (e.g. shards of the same job with different seeds), merged on read
+struct EvictionTrialPool {
+  ShardedMeanStat full, evict;
+};
+
+// Run `testN' targeted eviction set searches (create a candidate set, then trim it by random division)
+// on a new hierarchy built from `ccfg', with random targets seeded by `tcfg.seed'.
+// The hierarchy, random generator and the thread-local reporter are private to the call,
+// so trials can run on multiple threads.
+extern void
+eviction_trial
+(
+ const CacheCFG &ccfg,              // cache config
+ const TraverseTestCFG &tcfg,       // traverse config
+ traverse_func_t traverse_func,     // traverse function of the traverse config
+ uint32_t cache_level,              // the target cache level
+ uint32_t candidate_size,           // number of candidates
+ uint32_t split,                    // number of split in each pass
+ uint32_t testN,                    // number of searches
+ EvictionTrialResult *result,
+ EvictionTrialPool *pool = NULL     // also record the accesses here, shared by concurrent trials of the same setup
+ );
+
+#endif
@@ -2,6 +2,7 @@
 #include "util/query.hpp"
 #include "util/report.hpp"
 #include <boost/format.hpp>
+#include <algorithm>
 
 const uint32_t mem_delay = 200;  // currently this is a hack
 
@@ -41,6 +42,37 @@ bool CacheBase::query_coloc(uint64_t addrA, uint64_t addrB) {
   return get_index(NULL, addrA) == get_index(NULL, addrB);
 }
 
+uint64_t CacheBase::sample_estimate(SampledRatioStat *miss_rate) const {
+  if(sample <= 1) return 0;
+  miss_rate->add_population(nset);
+  uint64_t total = sample_filtered;
+  for(uint32_t idx=0; idx<nset; idx++)
+    if(sampled(idx)) {
+      miss_rate->record(sample_miss[idx], sample_access[idx]);
+      total += sample_access[idx];
+    }
+  return total;
+}
+
+void CacheBase::checkpoint() {
+  ckpt_meta.clear();
+  ckpt_enable = true;
+  replacer->checkpoint();
+}
+
+void CacheBase::rollback() {
+  for(auto &row : ckpt_meta)
+    memcpy(meta + nway * row.first, row.second.data(), sizeof(uint64_t)*nway);
+  ckpt_meta.clear();
+  replacer->rollback();
+}
+
+void CacheBase::discard_checkpoint() {
+  ckpt_meta.clear();
+  ckpt_enable = false;
+  replacer->discard_checkpoint();
+}
+
 void CoherentCache::replace(uint64_t *latency, uint64_t addr, uint32_t *idx, uint32_t *way) {
   *idx = cache->get_index(latency, addr);
   *way = cache->replace(latency, *idx);
@@ -50,8 +82,10 @@ void CoherentCache::replace(uint64_t *latency, uint64_t addr, uint32_t *idx, uin
 void CoherentCache::flush(uint64_t *latency, uint64_t addr, int32_t levels, uint32_t inner_id) {
   uint32_t idx, way;
   addr = CM::normalize(addr);
+  if(!inner_caches) reporter.cache_request(cache->core_id, AccessMonitor::REQ_FLUSH, addr);
   cache->latency_acc(latency);
-  if(cache->hit(latency, addr, &idx, &way))
+  bool sampled = cache->sample <= 1 || cache->sampled(cache->get_index(NULL, addr));
+  if(sampled && cache->hit(latency, addr, &idx, &way))
     evict(latency, idx, way);
   if(levels != 0 && outer_caches)
     outer_flush(latency, id, addr, levels-1);
@@ -65,36 +99,65 @@ void CoherentCache::flush_cache(uint64_t *latency, int32_t levels, uint32_t inne
     outer_flush_cache(latency, id, levels-1);
 }
 
+void CoherentCache::checkpoint(int32_t levels) {
+  cache->checkpoint();
+  if(levels != 0 && outer_caches)
+    for(auto oc: (*outer_caches)) oc->checkpoint(levels-1);
+}
+
+void CoherentCache::rollback(int32_t levels) {
+  cache->rollback();
+  if(levels != 0 && outer_caches)
+    for(auto oc: (*outer_caches)) oc->rollback(levels-1);
+}
+
+void CoherentCache::discard_checkpoint(int32_t levels) {
+  cache->discard_checkpoint();
+  if(levels != 0 && outer_caches)
+    for(auto oc: (*outer_caches)) oc->discard_checkpoint(levels-1);
+}
 
 void CoherentCache::read(uint64_t *latency, uint64_t addr, uint32_t inner_id) {
   addr = CM::normalize(addr);
+  if(!inner_caches) reporter.cache_request(cache->core_id, AccessMonitor::REQ_READ, addr);
+  if(cache->sample_filter(addr)) return;
   uint32_t idx, way;
-  bool h = true;
   cache->latency_acc(latency);
-  if(cache->hit(latency, addr, &idx, &way)) { // hit
+  bool h = cache->hit(latency, addr, &idx, &way);
+  read_line(latency, addr, idx, way, h, inner_id);
+}
+
+void CoherentCache::read_line(uint64_t *latency, uint64_t addr, uint32_t idx, uint32_t way, bool h, uint32_t inner_id) {
+  if(h) { // hit
     if(inner_caches && CM::is_modified(cache->get_meta(NULL, idx, way))) {
       inner_probe(latency, inner_id, addr, id, false, false);
       cache->set_meta(latency, idx, way, CM::to_shared(cache->get_meta(NULL, idx, way)));
     }
   } else {  //miss
-    h = false;
     replace(latency, addr, &idx, &way);
     if(outer_caches) outer_read(latency, id, addr);
     else if(latency) *latency += mem_delay;
     cache->set_meta(latency, idx, way, CM::to_shared(addr));
   }
   cache->access(idx, way);
+  cache->sample_record(idx, h);
   reporter.cache_access(cache->level, cache->core_id, cache->cache_id,
                         addr, idx, way, 1, h);
 }
 
 void CoherentCache::write(uint64_t *latency, uint64_t addr, uint32_t inner_id, bool to_dirty) {
   addr = CM::normalize(addr);
+  if(!inner_caches) reporter.cache_request(cache->core_id, AccessMonitor::REQ_WRITE, addr);
+  if(cache->sample_filter(addr)) return;
   uint32_t idx, way;
-  bool h = true;
   cache->latency_acc(latency);
+  bool h = cache->hit(latency, addr, &idx, &way);
+  write_line(latency, addr, idx, way, h, inner_id, to_dirty);
+}
+
+void CoherentCache::write_line(uint64_t *latency, uint64_t addr, uint32_t idx, uint32_t way, bool h, uint32_t inner_id, bool to_dirty) {
   uint64_t meta;
-  if(cache->hit(latency, addr, &idx, &way)) { // hit
+  if(h) { // hit
     if(inner_caches && CM::is_shared(cache->get_meta(NULL, idx, way))) {
       inner_probe(latency, inner_id, addr, id, true, false);
     }
@@ -104,7 +167,6 @@ void CoherentCache::write(uint64_t *latency, uint64_t addr, uint32_t inner_id, b
       meta = CM::to_modified(meta);
     }
   } else {  //miss
-    h = false;
     replace(latency, addr, &idx, &way);
     if(outer_caches) outer_write(latency, id, addr);
     else if(latency) *latency += mem_delay;
@@ -113,6 +175,7 @@ void CoherentCache::write(uint64_t *latency, uint64_t addr, uint32_t inner_id, b
   if(to_dirty) meta = CM::to_dirty(meta);
   cache->set_meta(latency, idx, way, meta);
   cache->access(idx, way);
+  cache->sample_record(idx, h);
   reporter.cache_access(cache->level, cache->core_id, cache->cache_id,
                         addr, idx, way, 2, h);
 }
@@ -174,6 +237,7 @@ void CoherentCache::evict(uint64_t *latency, uint32_t idx, uint32_t way) {
 void CoherentCache::release(uint64_t *latency, uint64_t addr, uint32_t inner_id) {
   uint32_t idx, way;
   cache->latency_acc(latency);
+  if(cache->sample > 1 && !cache->sampled(cache->get_index(NULL, addr))) return;
   if(cache->hit(latency, addr, &idx, &way)) { // hit
     uint64_t meta = cache->get_meta(NULL, idx, way);
     meta = CM::to_shared(meta);
@@ -187,3 +251,31 @@ void CoherentCache::release(uint64_t *latency, uint64_t addr, uint32_t inner_id)
   reporter.cache_access(cache->level, cache->core_id, cache->cache_id,
                         addr, idx, way, 1, true);
 }
+
+void L1CacheBase::access_batch(const uint64_t *addrs, size_t n, uint64_t *latency, bool *hit, bool write) {
+  const size_t chunk = 64;
+  uint64_t lines[chunk];
+  uint32_t sets[chunk];
+  for(size_t s=0; s<n; s+=chunk) {
+    size_t m = std::min(chunk, n - s);
+    for(size_t i=0; i<m; i++) {
+      uint64_t *l = latency ? latency + s + i : NULL;
+      if(l) *l = 0;
+      lines[i] = CM::normalize(addrs[s+i]);
+      sets[i] = cache->get_index(l, lines[i]);
+    }
+    for(size_t i=0; i<m; i++) {
+      uint64_t *l = latency ? latency + s + i : NULL;
+      uint32_t way;
+      bool h = false;
+      reporter.cache_request(cache->core_id, write ? AccessMonitor::REQ_WRITE : AccessMonitor::REQ_READ, lines[i]);
+      if(!cache->sample_filter_set(sets[i])) {
+        cache->latency_acc(l);
+        h = cache->hit_set(lines[i], sets[i], &way);
+        if(write) write_line(l, lines[i], sets[i], way, h, 0, true);
+        else      read_line(l, lines[i], sets[i], way, h, 0);
+      }
+      if(hit) hit[s+i] = h;
+    }
+  }
+}
@@ -10,6 +10,7 @@
 #include "cache/index.hpp"
 #include "cache/tag.hpp"
 #include "cache/llchash.hpp"
+#include "util/statistics.hpp"
 
 /////////////////////////////////
 // Base class for all caches
@@ -23,25 +24,39 @@ protected:
   uint64_t *meta;      // metadata array
   friend CoherentCache;
 
+  // checkpoint: meta rows of the sets modified since the last checkpoint
+  bool ckpt_enable;
+  std::unordered_map<uint32_t, std::vector<uint64_t> > ckpt_meta;
+
+  // set sampling: access and miss counters of the sampled sets, accesses to the unsampled sets
+  std::vector<uint64_t> sample_access, sample_miss;
+  uint64_t sample_filtered;
+
 public:
   uint32_t level;      // cache level (L1, L2, L3)
   int32_t core_id;     // when private, record the core id, -1 means unified (LLC)
   uint32_t cache_id;   // record the cache id in a core or just cache id when unified (LLC)
   uint32_t nset, nway; // number of sets and ways
+  uint32_t sample;     // simulate only one in `sample' sets chosen by an index hash (1 for all sets)
 
   CacheBase(uint32_t nset, uint32_t nway,
             indexer_creator_t ic,
             tagger_creator_t tc,
             replacer_creator_t rc,
             uint32_t level, int32_t core_id, uint32_t cache_id,
-            uint32_t delay)
+            uint32_t delay, uint32_t sample = 1)
     : DelaySim(delay),
-      indexer(ic(nset)), tagger(tc(nset)), replacer(rc(nset, nway)),
+      indexer(ic(nset)), tagger(tc(nset)),
+      replacer(rc(nset, nway, ((uint64_t)level << 56) ^ ((uint64_t)(uint32_t)core_id << 24) ^ cache_id)),
+      ckpt_enable(false), sample_filtered(0),
       level(level), core_id(core_id), cache_id(cache_id),
-      nset(nset), nway(nway)
+      nset(nset), nway(nway), sample(sample)
   {
-    size_t s = sizeof(uint64_t)*nset*nway;
-    meta = (uint64_t *)malloc(s); memset(meta, 0, s);
+    meta = (uint64_t *)calloc(nset*nway, sizeof(uint64_t)); // pages of untouched sets are never mapped
+    if(sample > 1) {
+      sample_access.resize(nset, 0);
+      sample_miss.resize(nset, 0);
+    }
   }
 
   virtual ~CacheBase() {
@@ -62,6 +77,8 @@ public:
 
   void set_meta(uint64_t *latency, uint32_t idx, uint32_t way, uint64_t m_meta) {
     latency_acc(latency);
+    if(ckpt_enable && !ckpt_meta.count(idx))
+      ckpt_meta[idx] = std::vector<uint64_t>(meta + nway * idx, meta + nway * (idx + 1));
     meta[nway * idx + way] = m_meta;
   }
 
@@ -70,11 +87,48 @@ public:
     return hit(NULL, addr, &idx, &way);
   }
 
+  // whether set `idx' is among the one in `sample' sets chosen by a multiplicative hash of the index
+  static bool sampled(uint32_t idx, uint32_t sample) {
+    return sample <= 1 || ((idx * 0x9e3779b97f4a7c15ull) >> 32) % sample == 0;
+  }
+  bool sampled(uint32_t idx) const { return sampled(idx, sample); }
+
+  // true when the access to `addr' falls in an unsampled set and should be dropped (by its set `idx' when known)
+  bool sample_filter(uint64_t addr) {
+    return sample > 1 && sample_filter_set(get_index(NULL, addr));
+  }
+  bool sample_filter_set(uint32_t idx) {
+    if(sample <= 1 || sampled(idx)) return false;
+    sample_filtered++;
+    return true;
+  }
+
+  void sample_record(uint32_t idx, bool hit) {
+    if(sample <= 1) return;
+    sample_access[idx]++;
+    if(!hit) sample_miss[idx]++;
+  }
+
+  // accesses and misses recorded in sampled set `idx'
+  void sample_counts(uint32_t idx, uint64_t *access, uint64_t *miss) const {
+    *access = sample <= 1 ? 0 : sample_access[idx];
+    *miss   = sample <= 1 ? 0 : sample_miss[idx];
+  }
+
+  // add the sampled sets to a miss rate estimate, return the number of accesses (sampled and filtered),
+  // nothing is added without sampling
+  uint64_t sample_estimate(SampledRatioStat *miss_rate) const;
+
   virtual bool hit(uint64_t *latency, uint64_t addr, uint32_t *idx, uint32_t *way) {
     *idx = get_index(latency, addr);
+    return hit_set(addr, *idx, way);
+  }
+
+  // look up `addr' in set `idx' already computed by get_index()
+  bool hit_set(uint64_t addr, uint32_t idx, uint32_t *way) const {
+    const uint64_t *row = meta + nway * idx;
     for(unsigned int i=0; i<nway; i++) {
-      uint64_t meta = get_meta(NULL, *idx, i);
-      if(tagger->match(meta, addr) && !CM::is_invalid(meta)) {
+      if(tagger->match(row[i], addr) && !CM::is_invalid(row[i])) {
         *way = i;
         return true;
       }
@@ -86,6 +140,11 @@ public:
   virtual void access(uint32_t idx, uint32_t way)  { replacer->access(idx, way);    }
   virtual void invalid(uint32_t idx, uint32_t way) { replacer->invalid(idx, way);   }
 
+  // checkpoint/rollback of the cache state (meta and replacement state)
+  virtual void checkpoint();
+  virtual void rollback();
+  virtual void discard_checkpoint();
+
   std::string cache_name() const;
   virtual void query_block(uint32_t idx, uint32_t way, CBInfo *info) const;
   virtual void query_set(uint32_t idx, SetInfo *info) const;
@@ -99,18 +158,20 @@ public:
                             uint32_t level,
                             int32_t core_id,
                             uint32_t cache_id,
-                            uint32_t delay
+                            uint32_t delay,
+                            uint32_t sample
                             ) {
-    return (CacheBase *)(new CacheBase(nset, nway, ic, tc, rc, level, core_id, cache_id, delay));
+    return (CacheBase *)(new CacheBase(nset, nway, ic, tc, rc, level, core_id, cache_id, delay, sample));
   }
 
   static cache_creator_t gen(uint32_t nset, uint32_t nway,
                              indexer_creator_t ic,
                              tagger_creator_t tc,
                              replacer_creator_t rc,
-                             uint32_t delay = 0) {
+                             uint32_t delay = 0,
+                             uint32_t sample = 1) {
     using namespace std::placeholders;
-    return std::bind(factory, nset, nway, ic, tc, rc, _1, _2, _3, delay);
+    return std::bind(factory, nset, nway, ic, tc, rc, _1, _2, _3, delay, sample);
   }
 };
 
@@ -146,6 +207,7 @@ public:
   std::string cache_name() const { return cache->cache_name(); }
   bool hit(uint64_t addr) { return cache->hit(addr); }
   uint32_t get_index(uint64_t addr) { return cache->get_index(NULL, addr); }
+  uint64_t sample_estimate(SampledRatioStat *miss_rate) const { return cache->sample_estimate(miss_rate); }
 
   virtual void read(uint64_t *latency, uint64_t addr, uint32_t inner_id);
   virtual void write(uint64_t *latency, uint64_t addr, uint32_t inner_id, bool to_dirty = false);
@@ -153,6 +215,15 @@ public:
   virtual void flush(uint64_t *latency, uint64_t addr, int32_t levels, uint32_t inner_id);
   virtual void flush_cache(uint64_t *latency, int32_t levels, uint32_t inner_id);
   virtual void probe(uint64_t *latency, uint64_t addr, bool invalid);
+
+  // Save the current state of this cache and `levels' of outer caches (-1 for all),
+  // so that it can be restored by rollback() in O(number of sets touched).
+  // Accesses recorded by the reporter are not rolled back.
+  // All caches of a hierarchy sharing the outer caches should be checkpointed together.
+  virtual void checkpoint(int32_t levels);
+  virtual void rollback(int32_t levels);
+  virtual void discard_checkpoint(int32_t levels);
+
   virtual void query_block(uint32_t idx, uint32_t way, CBInfo *info) const {
     cache->query_block(idx, way, info);
   }
@@ -191,6 +262,11 @@ public:
 protected:
   virtual void replace(uint64_t *latency, uint64_t addr, uint32_t *idx, uint32_t *way);
   virtual void evict(uint64_t *latency, uint32_t idx, uint32_t way);
+
+  // the rest of a read/write once the normalized `addr' has been looked up:
+  // `h' whether it hits, then in way `way' of set `idx'
+  void read_line(uint64_t *latency, uint64_t addr, uint32_t idx, uint32_t way, bool h, uint32_t inner_id);
+  void write_line(uint64_t *latency, uint64_t addr, uint32_t idx, uint32_t way, bool h, uint32_t inner_id, bool to_dirty);
 };
 
 /////////////////////////////////
@@ -216,6 +292,9 @@ public:
   using CoherentCache::write;
   using CoherentCache::flush;
   using CoherentCache::flush_cache;
+  using CoherentCache::checkpoint;
+  using CoherentCache::rollback;
+  using CoherentCache::discard_checkpoint;
 
   void read(uint64_t addr)  { read(NULL, addr, 0);  }
   void write(uint64_t addr) { write(NULL, addr, 0, true); }
@@ -225,6 +304,28 @@ public:
   void write(uint64_t *latency, uint64_t addr) { write(latency, addr, 0, true); }
   void flush(uint64_t *latency, uint64_t addr) { flush(latency, addr, -1, 0); }
   void flush_cache(uint64_t *latency)          { flush_cache(latency, 0, 0); } // flush L1 by default
+  void checkpoint()                            { checkpoint(-1); }         // the whole hierarchy by default
+  void rollback()                              { rollback(-1); }
+  void discard_checkpoint()                    { discard_checkpoint(-1); }
+
+  // batched accesses of n addresses
+  //   latency: optional output of the latency of every access
+  //   hit:     optional output of whether every access hits in this cache
+  void read_batch(const uint64_t *addrs, size_t n, uint64_t *latency = NULL, bool *hit = NULL)  { access_batch(addrs, n, latency, hit, false); }
+  void write_batch(const uint64_t *addrs, size_t n, uint64_t *latency = NULL, bool *hit = NULL) { access_batch(addrs, n, latency, hit, true);  }
+
+  // whether an access is served by this cache alone (a read hit or a write hit to a modified line),
+  // checked without side effects
+  bool local(uint64_t addr, bool write) {
+    uint32_t idx, way;
+    if(!cache->hit(NULL, CM::normalize(addr), &idx, &way)) return false;
+    return !write || CM::is_modified(cache->get_meta(NULL, idx, way));
+  }
+
+protected:
+  // the addresses of a batch are normalized and indexed up front, every access then completes
+  // from its lookup without virtual dispatch, only misses and upgrades go through the outer caches
+  void access_batch(const uint64_t *addrs, size_t n, uint64_t *latency, bool *hit, bool write);
 };
 
 /////////////////////////////////
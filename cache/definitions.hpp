@@ -16,7 +16,8 @@ class LLCHashBase;
 
 typedef std::function<IndexFuncBase *(uint32_t)> indexer_creator_t;
 typedef std::function<TagFuncBase *(uint32_t)> tagger_creator_t;
-typedef std::function<ReplaceFuncBase *(uint32_t, uint32_t)> replacer_creator_t;
+// nset, nway and the identity of the cache (level, core and cache id), which randomized policies mix into their seed
+typedef std::function<ReplaceFuncBase *(uint32_t, uint32_t, uint64_t)> replacer_creator_t;
 typedef std::function<LLCHashBase *(uint32_t)> llc_hash_creator_t;
 typedef std::function<CacheBase *(uint32_t, int32_t, uint32_t)> cache_creator_t;
 
@@ -24,9 +25,14 @@ typedef std::function<CacheBase *(uint32_t, int32_t, uint32_t)> cache_creator_t;
 extern std::vector<CoherentCache *> l1_caches;     // list of L1 caches
 extern std::vector<CoherentCache *> llc_caches;    // list of LLCs
 
-// event tracer
+// event tracer, one per thread so that independent simulations can run on multiple threads
+//   Every program linking the model must define it once, as thread_local (a plain global
+//   `Reporter_t reporter;' defined by code written for earlier versions no longer links):
+//     thread_local Reporter_t reporter;
+//   Events are recorded by the reporter of the thread running the simulation, so tracers and
+//   monitors must be registered on that thread.
 class Reporter_t;
-extern Reporter_t reporter;
+extern thread_local Reporter_t reporter;
 
 /////////////////////////////////
 // cache model functions
@@ -9,6 +9,41 @@
 #include <string>
 #include "util/random.hpp"
 
+///////////////////////////////////
+// Per-set state backup for checkpoint/rollback
+//   the state of a set is copied when it is first modified after a checkpoint,
+//   so a rollback only costs the number of sets touched since then
+
+template<typename T>
+class SetBackup
+{
+  std::unordered_map<uint32_t, T> &state;
+  std::unordered_map<uint32_t, std::pair<bool, T> > saved; // <existed, state> at checkpoint
+  bool enable;
+public:
+  SetBackup(std::unordered_map<uint32_t, T> &state) : state(state), enable(false) {}
+
+  void backup(uint32_t set) {
+    if(enable && !saved.count(set)) {
+      auto it = state.find(set);
+      if(it != state.end()) saved[set] = std::make_pair(true, it->second);
+      else                  saved[set] = std::make_pair(false, T());
+    }
+  }
+
+  void checkpoint() { saved.clear(); enable = true; }
+
+  void rollback() {
+    for(auto &s : saved) {
+      if(s.second.first) state[s.first] = s.second.second;
+      else               state.erase(s.first);
+    }
+    saved.clear();
+  }
+
+  void discard() { saved.clear(); enable = false; }
+};
+
 ///////////////////////////////////
 // Base class
 
@@ -24,6 +59,9 @@ public:
   virtual void invalid(uint32_t set, uint32_t way) = 0;
   virtual std::string to_string(uint32_t set) const = 0;
   virtual std::string to_string() const = 0;
+  virtual void checkpoint() = 0;          // start recording state changes
+  virtual void rollback() = 0;            // restore the state of the last checkpoint
+  virtual void discard_checkpoint() = 0;  // stop recording state changes
   virtual ~ReplaceFuncBase() {}
 };
 
@@ -33,39 +71,56 @@ public:
 class ReplaceRandom : public ReplaceFuncBase
 {
   std::unordered_map<uint32_t, std::unordered_set<uint32_t> > free_map;
+  SetBackup<std::unordered_set<uint32_t> > free_backup;
+  // every set draws its own victim sequence (the n-th draw of a set is seeded by the set and n),
+  // so victims do not depend on the accesses to other sets, nor on which sets a cache object simulates;
+  // the draw counters are restored on rollback so victims are drawn again
+  std::unordered_map<uint32_t, uint64_t> draws;
+  SetBackup<uint64_t> draws_backup;
+  uint64_t seed;
 public:
-  ReplaceRandom(uint32_t nset, uint32_t nway, uint32_t delay) : ReplaceFuncBase(nset, nway, delay) {}
+  ReplaceRandom(uint32_t nset, uint32_t nway, uint32_t delay, uint64_t seed)
+    : ReplaceFuncBase(nset, nway, delay), free_backup(free_map), draws_backup(draws), seed(seed) {}
   virtual uint32_t replace(uint64_t *latency, uint32_t set){
     latency_acc(latency);
+    free_backup.backup(set);
     if(!free_map.count(set))
       for(uint32_t i=0; i<nway; i++) free_map[set].insert(i);
 
     if(free_map[set].size() > 0)
       return *(free_map[set].begin());
-    else
-      return (uint32_t)get_random_uint64(nway);
+    draws_backup.backup(set);
+    RandomGen rng(hash(seed ^ ((uint64_t)set << 32)) + draws[set]++);
+    return (uint32_t)rng.uniform(nway);
   }
   virtual void access(uint32_t set, uint32_t way) {
+    free_backup.backup(set);
     if(free_map[set].count(way))
       free_map[set].erase(way);
   }
   virtual void invalid(uint32_t set, uint32_t way) {
+    free_backup.backup(set);
     free_map[set].insert(way);
   }
 
+  virtual void checkpoint()         { free_backup.checkpoint(); draws_backup.checkpoint(); }
+  virtual void rollback()           { free_backup.rollback();   draws_backup.rollback();   }
+  virtual void discard_checkpoint() { free_backup.discard();    draws_backup.discard();    }
+
   // there is not need to print for random replacement
   virtual std::string to_string(uint32_t set) const { return std::string(); }
   virtual std::string to_string() const { return std::string(); }
 
   virtual ~ReplaceRandom() {}
 
-  static ReplaceFuncBase *factory(uint32_t nset, uint32_t nway, uint32_t delay) {
-    return (ReplaceFuncBase *)(new ReplaceRandom(nset, nway, delay));
+  // caches sharing a config draw independent victim sequences
+  static ReplaceFuncBase *factory(uint32_t nset, uint32_t nway, uint32_t delay, uint64_t seed, uint64_t cache) {
+    return (ReplaceFuncBase *)(new ReplaceRandom(nset, nway, delay, seed ^ hash(cache)));
   }
 
-  static replacer_creator_t gen(uint32_t delay = 0) {
+  static replacer_creator_t gen(uint32_t delay = 0, uint64_t seed = 0) {
     using namespace std::placeholders;
-    return std::bind(factory, _1, _2, delay);
+    return std::bind(factory, _1, _2, delay, seed, _3);
   }
 };
 
@@ -77,13 +132,19 @@ class ReplaceFIFO : public ReplaceFuncBase
 protected:
   std::unordered_map<uint32_t, std::list<uint32_t> > used_map;
   std::unordered_map<uint32_t, std::unordered_set<uint32_t> > free_map;
+  SetBackup<std::list<uint32_t> > used_backup;
+  SetBackup<std::unordered_set<uint32_t> > free_backup;
+
+  void backup(uint32_t set) { used_backup.backup(set); free_backup.backup(set); }
 
 public:
 
-  ReplaceFIFO(uint32_t nset, uint32_t nway, uint32_t delay) : ReplaceFuncBase(nset, nway, delay) {}
+  ReplaceFIFO(uint32_t nset, uint32_t nway, uint32_t delay)
+    : ReplaceFuncBase(nset, nway, delay), used_backup(used_map), free_backup(free_map) {}
 
   virtual uint32_t replace(uint64_t *latency, uint32_t set) {
     latency_acc(latency);
+    backup(set);
     if(!free_map.count(set))
       for(uint32_t i=0; i<nway; i++) free_map[set].insert(i);
 
@@ -94,6 +155,7 @@ public:
   }
 
   virtual void access(uint32_t set, uint32_t way) {
+    backup(set);
     if(free_map[set].count(way)) {
       free_map[set].erase(way);
       used_map[set].push_back(way);
@@ -101,10 +163,15 @@ public:
   }
 
   virtual void invalid(uint32_t set, uint32_t way) {
+    backup(set);
     used_map[set].remove(way);
     free_map[set].insert(way);
   }
 
+  virtual void checkpoint()         { used_backup.checkpoint(); free_backup.checkpoint(); }
+  virtual void rollback()           { used_backup.rollback();   free_backup.rollback();   }
+  virtual void discard_checkpoint() { used_backup.discard();    free_backup.discard();    }
+
   virtual std::string to_string(uint32_t set) const;
   virtual std::string to_string() const;
   virtual ~ReplaceFIFO() {}
@@ -130,6 +197,7 @@ public:
   ReplaceLRU(uint32_t nset, uint32_t nway, uint32_t delay) : ReplaceFIFO(nset, nway, delay) {}
  
   virtual void access(uint32_t set, uint32_t way) {
+    backup(set);
     if(free_map[set].count(way)) {
       free_map[set].erase(way);
       used_map[set].push_back(way);
@@ -161,14 +229,16 @@ class ReplaceRRIP : public ReplaceFuncBase
 {
 protected:
   std::unordered_map<uint32_t, std::vector<uint32_t> > rrpv_map;
+  SetBackup<std::vector<uint32_t> > rrpv_backup;
   uint32_t rrpv_max;
 
 public:
   ReplaceRRIP(uint32_t nset, uint32_t nway, uint32_t width, uint32_t delay)
-    : ReplaceFuncBase(nset, nway, delay), rrpv_max(1<<width) {}
+    : ReplaceFuncBase(nset, nway, delay), rrpv_backup(rrpv_map), rrpv_max(1<<width) {}
 
   virtual uint32_t replace(uint64_t *latency, uint32_t set) {
     latency_acc(latency);
+    rrpv_backup.backup(set);
     if(!rrpv_map.count(set))
       rrpv_map[set] = std::vector<uint32_t>(nway, rrpv_max);
 
@@ -185,6 +255,7 @@ public:
   }
 
   virtual void access(uint32_t set, uint32_t way) {
+    rrpv_backup.backup(set);
     if(rrpv_map[set][way] == rrpv_max)
       rrpv_map[set][way] = rrpv_max - 2;
     else
@@ -192,10 +263,15 @@ public:
   }
 
   virtual void invalid(uint32_t set, uint32_t way) {
+    rrpv_backup.backup(set);
     if(rrpv_map.count(set))
       rrpv_map[set][way] = rrpv_max;
   }
 
+  virtual void checkpoint()         { rrpv_backup.checkpoint(); }
+  virtual void rollback()           { rrpv_backup.rollback();   }
+  virtual void discard_checkpoint() { rrpv_backup.discard();    }
+
   virtual std::string to_string(uint32_t set) const;
   virtual std::string to_string() const;
   virtual ~ReplaceRRIP() {}
@@ -0,0 +1,153 @@
+#include "capi/cache_model.h"
+#include "cache/cache.hpp"
+#include "util/report.hpp"
+#include "util/replay.hpp"
+#include "util/cache_config_parser.hpp"
+#include <string>
+#include <cstring>
+#include <memory>
+
+#ifdef CM_REPORTER_DISABLE
+#error "the C interface counts events through the reporter, it cannot be built with REPORTER=0"
+#endif
+
+// the globals a host program would otherwise define
+thread_local Reporter_t reporter;
+
+static_assert(sizeof(cm_access_t) == sizeof(TraceRecord), "cm_access_t and TraceRecord differ");
+static_assert((int)CM_READ == TraceRecord::READ && (int)CM_WRITE == TraceRecord::WRITE && (int)CM_FLUSH == TraceRecord::FLUSH,
+              "cm_access_t and TraceRecord ops differ");
+
+static thread_local std::string last_error;
+
+// run the body of an entry point, exceptions must not cross the C interface:
+// they are turned into `last_error' and the failure value `fail'
+template<typename T, typename F>
+static T guarded(T fail, F body) {
+  try {
+    return body();
+  } catch(std::exception &e) {
+    last_error = e.what();
+  } catch(...) {
+    last_error = "unknown exception in the cache model";
+  }
+  return fail;
+}
+
+// counts the events of a hierarchy, attached to the reporter of the calling thread during accesses
+class CounterMonitor : public AccessMonitor
+{
+public:
+  std::vector<cm_counters_t> levels;  // [0] unused
+  std::vector<cm_counters_t> l1;      // per core
+
+  virtual void access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit) {
+    if(level >= levels.size()) return;
+    levels[level].access++;
+    if(!hit) levels[level].miss++;
+    if(level == 1 && core_id >= 0 && (size_t)core_id < l1.size()) {
+      l1[core_id].access++;
+      if(!hit) l1[core_id].miss++;
+    }
+  }
+
+  virtual void evict(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
+    if(level >= levels.size()) return;
+    levels[level].evict++;
+    if(level == 1 && core_id >= 0 && (size_t)core_id < l1.size()) l1[core_id].evict++;
+  }
+
+  void clear() {
+    for(auto &c : levels) c = cm_counters_t();
+    for(auto &c : l1) c = cm_counters_t();
+  }
+};
+
+struct cm_hierarchy {
+  CacheCFG ccfg;
+  std::vector<CoherentCache *> l1_caches, l2_caches;
+  CounterMonitor monitor;
+};
+
+uint32_t cm_version(void) { return CM_API_VERSION; }
+
+const char *cm_last_error(void) { return last_error.c_str(); }
+
+cm_hierarchy_t *cm_create(const char *config_file, const char *config_name) {
+  if(!config_file || !config_name) {
+    last_error = "no cache config file or config name";
+    return NULL;
+  }
+  std::unique_ptr<cm_hierarchy_t> h;
+  cm_hierarchy_t *rv = guarded<cm_hierarchy_t *>(NULL, [&]() -> cm_hierarchy_t * {
+      h.reset(new cm_hierarchy_t);
+      std::string error;
+      if(!cache_config_parser(config_file, config_name, &h->ccfg, &error)) {
+        last_error = error;
+        return NULL;
+      }
+      build_hierarchy(h->ccfg, &h->l1_caches, &h->l2_caches);
+      h->monitor.levels.resize(cm_num_levels(h.get()) + 1);
+      h->monitor.l1.resize(h->ccfg.number[0]);
+      return h.get();
+    });
+  if(!rv && h) release_hierarchy(&h->l1_caches, &h->l2_caches);  // caches built before a failure
+  return rv ? h.release() : NULL;
+}
+
+void cm_destroy(cm_hierarchy_t *h) {
+  if(!h) return;
+  guarded<int>(-1, [&]() {
+      release_hierarchy(&h->l1_caches, &h->l2_caches);
+      return 0;
+    });
+  delete h;
+}
+
+uint32_t cm_num_cores(const cm_hierarchy_t *h)  { return h->l1_caches.size(); }
+uint32_t cm_num_levels(const cm_hierarchy_t *h) { return h->ccfg.enable[1] ? 2 : 1; }
+
+static size_t access_batch(cm_hierarchy_t *h, const cm_access_t *accesses, size_t n, uint8_t *hit, uint64_t *latency) {
+  bool hits[replay_batch];
+  if(hit) memset(hit, 0, n);    // also for flushes and skipped accesses
+  if(latency) memset(latency, 0, n * sizeof(uint64_t));
+  reporter.attach_monitor(&h->monitor);
+  size_t rv = replay_runs(accesses, n, h->l1_caches, [&](L1CacheBase *cache, uint8_t op, size_t pos, const uint64_t *addrs, size_t m) {
+      uint64_t *l = latency ? latency + pos : NULL;
+      if(op == CM_FLUSH) { cache->flush(l, addrs[0]); return; }
+      if(op == CM_READ) cache->read_batch(addrs, m, l, hit ? hits : NULL);
+      else              cache->write_batch(addrs, m, l, hit ? hits : NULL);
+      if(hit) for(size_t k=0; k<m; k++) hit[pos+k] = hits[k];
+    });
+  reporter.detach_monitor(&h->monitor);
+  return rv;
+}
+
+size_t cm_access_batch(cm_hierarchy_t *h, const cm_access_t *accesses, size_t n, uint8_t *hit, uint64_t *latency) {
+  size_t rv = guarded<size_t>(CM_ACCESS_ERROR, [&]() { return access_batch(h, accesses, n, hit, latency); });
+  if(rv == CM_ACCESS_ERROR) reporter.detach_monitor(&h->monitor);
+  return rv;
+}
+
+int cm_access(cm_hierarchy_t *h, uint16_t core, uint8_t op, uint64_t addr) {
+  cm_access_t a = {addr, core, op, {0, 0, 0, 0, 0}};
+  uint8_t hit;
+  size_t n = cm_access_batch(h, &a, 1, &hit, NULL);
+  if(n == 0 || n == CM_ACCESS_ERROR) return -1;
+  return hit;
+}
+
+int cm_get_counters(const cm_hierarchy_t *h, uint32_t level, int32_t core, cm_counters_t *counters) {
+  if(level < 1 || level > cm_num_levels(h) || (core >= 0 && (level != 1 || (size_t)core >= h->monitor.l1.size()))) {
+    last_error = "no such cache";
+    return -1;
+  }
+  return guarded<int>(-1, [&]() {
+      *counters = core >= 0 ? h->monitor.l1[core] : h->monitor.levels[level];
+      return 0;
+    });
+}
+
+void cm_clear_counters(cm_hierarchy_t *h) {
+  guarded<int>(-1, [&]() { h->monitor.clear(); return 0; });
+}
@@ -0,0 +1,70 @@
+/* C interface of the cache model, for embedding in simulators (Spike, QEMU plugins, ...)
+ *   Link with libcache_model.so; the host does not define any global.
+ *   A hierarchy is not thread-safe, but different hierarchies can be used on different threads.
+ *   No exception crosses this interface: failures return NULL or an error value, see cm_last_error().
+ */
+#ifndef CM_CAPI_CACHE_MODEL_H_
+#define CM_CAPI_CACHE_MODEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* only the cm_* functions are exported from the shared library */
+#define CM_EXPORT __attribute__((visibility("default")))
+
+/* bumped on incompatible changes of this interface, compare with cm_version() at run time */
+#define CM_API_VERSION 1
+
+enum { CM_READ = 0, CM_WRITE = 1, CM_FLUSH = 2 };
+
+/* a memory access of a core, the same layout as a record of a native trace (util/trace.hpp) */
+typedef struct {
+  uint64_t addr;
+  uint16_t core;
+  uint8_t  op;      /* CM_READ, CM_WRITE or CM_FLUSH */
+  uint8_t  pad[5];
+} cm_access_t;
+
+/* events of a cache level, accesses include coherence probes and write-backs from inner caches */
+typedef struct {
+  uint64_t access;
+  uint64_t miss;
+  uint64_t evict;
+} cm_counters_t;
+
+typedef struct cm_hierarchy cm_hierarchy_t;
+
+CM_EXPORT uint32_t cm_version(void);
+CM_EXPORT const char *cm_last_error(void);   /* the last error of the calling thread */
+
+/* create a hierarchy from a named config of a config file (e.g. config/cache.json), NULL on error */
+CM_EXPORT cm_hierarchy_t *cm_create(const char *config_file, const char *config_name);
+CM_EXPORT void cm_destroy(cm_hierarchy_t *h);
+
+CM_EXPORT uint32_t cm_num_cores(const cm_hierarchy_t *h);
+CM_EXPORT uint32_t cm_num_levels(const cm_hierarchy_t *h);
+
+/* returned by cm_access_batch() on an internal error, the hierarchy should not be used any more */
+#define CM_ACCESS_ERROR ((size_t)-1)
+
+/* simulate n accesses in order, return the number of valid accesses simulated or CM_ACCESS_ERROR
+ *   hit:     optional output, whether every access hits in the L1 of its core
+ *   latency: optional output, the modelled latency of every access
+ */
+CM_EXPORT size_t cm_access_batch(cm_hierarchy_t *h, const cm_access_t *accesses, size_t n, uint8_t *hit, uint64_t *latency);
+/* a single access, return 1 for an L1 hit, 0 for a miss and -1 for an invalid access or an error */
+CM_EXPORT int cm_access(cm_hierarchy_t *h, uint16_t core, uint8_t op, uint64_t addr);
+
+/* counters of a level (1 for L1), summed over its caches when core < 0, otherwise of the L1 of a core */
+CM_EXPORT int cm_get_counters(const cm_hierarchy_t *h, uint32_t level, int32_t core, cm_counters_t *counters);
+CM_EXPORT void cm_clear_counters(cm_hierarchy_t *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,14 +1,15 @@
 #include "test/common.hpp"
 
 int main(int argc, char* argv[]) {
-  if(argc != 2) {
-    std::cerr << "Usage: cache-test <cache-config>" << std::endl;
+  if(argc != 2 && argc != 3) {
+    std::cerr << "Usage: cache-test <cache-config> [event-trace]" << std::endl;
     return 1;
   }
 
   if(!cache_config_parser("config/cache.json", argv[1], &ccfg)) return 1;
   cache_init();
   L1CacheBase *entry = (L1CacheBase *)l1_caches[0];
+  if(argc == 3 && !reporter.open_event_trace(argv[2])) return 1;
 
   for(int i=0; i<1000; i++) {
     uint64_t addr = i*64;
@@ -21,6 +22,11 @@ int main(int argc, char* argv[]) {
     entry->read(addr);
   }
 
+  bool written = reporter.close_event_trace();
   cache_release();
+  if(!written) {
+    std::cerr << "Fail to write event trace " << argv[2] << std::endl;
+    return 1;
+  }
   return 0;
 }
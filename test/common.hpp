@@ -9,7 +9,7 @@
 #include "util/statistics.hpp"
 #include "util/cache_config_parser.hpp"
 #include "util/traverse_config_parser.hpp"
-#include "datagen/include/random_generator.h"
+#include "util/random.hpp"
 
 #include <iostream>
 #include <iomanip>
@@ -17,9 +17,10 @@
 #include <cstdlib>
 #include <boost/format.hpp>
 
-Reporter_t reporter;
+thread_local Reporter_t reporter;
 CacheCFG ccfg;
 TraverseTestCFG tcfg;
+RandomGen rng;
 
 std::vector<CoherentCache *>  l1_caches;
 std::vector<CoherentCache *>  l2_caches;
@@ -29,23 +30,12 @@ check_func_t check;
 traverse_test_t traverse;
 
 void cache_init() {
-  l1_caches.resize(ccfg.number[0]);
-  if(ccfg.enable[1]) l2_caches.resize(ccfg.number[1]);
-
-  for(int i=0; i<ccfg.number[0]; i++)
-    l1_caches[i] = new L1CacheBase(i, i, 0, ccfg.cache_gen[0], ccfg.enable[1] ? &l2_caches : NULL, ccfg.hash_gen[0]);
-
-  if(ccfg.enable[1]) {
-    for(int i=0; i<ccfg.number[1]; i++)
-      l2_caches[i] = new LLCCacheBase(i, 2, ccfg.cache_gen[1], &l1_caches);
-  }
-
-  random_seed_gen64();
+  build_hierarchy(ccfg, &l1_caches, &l2_caches);
+  rng.seed(tcfg.seed);
 }
 
 void cache_release() {
-  for(int i=0; i<ccfg.number[0]; i++) delete l1_caches[i];
-  if(ccfg.enable[1]) for(int i=0; i<ccfg.number[1]; i++) delete l2_caches[i];
+  release_hierarchy(&l1_caches, &l2_caches);
 }
 
 LocInfo get_target_cache(uint64_t addr, L1CacheBase *cache, uint32_t level, bool print = false) {
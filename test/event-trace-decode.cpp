@@ -0,0 +1,22 @@
+#include "util/event_trace.hpp"
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+  if(argc != 2) {
+    std::cerr << "Usage: event-trace-decode <event-trace>" << std::endl;
+    return 1;
+  }
+
+  EventTraceReader reader;
+  if(!reader.open(argv[1])) {
+    std::cerr << "Fail to open event trace " << argv[1] << std::endl;
+    return 1;
+  }
+
+  EventRecord r;
+  while(reader.read(&r))
+    std::cout << event_to_string(r) << std::endl;
+
+  reader.close();
+  return 0;
+}
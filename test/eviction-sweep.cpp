@@ -0,0 +1,110 @@
+#include "test/common.hpp"
+#include "attack/trial.hpp"
+#include <thread>
+#include <atomic>
+#include <sstream>
+
+static std::vector<std::string> split_list(const std::string &s) {
+  std::vector<std::string> rv;
+  std::stringstream ss(s);
+  std::string item;
+  while(std::getline(ss, item, ',')) if(!item.empty()) rv.push_back(item);
+  return rv;
+}
+
+// the searches of a job are split into shards of `shard_trials' seeded by `seed + shard',
+// shards run on any thread and record into the pool of their job
+const uint32_t shard_trials = 16;
+
+struct SweepJob {
+  uint32_t cache, traverse, candidate_size, split;
+  EvictionTrialPool pool;
+  QuantileSketch evict_dist;      // merged from the shards
+};
+
+struct SweepShard {
+  uint32_t job, index, trials;
+  EvictionTrialResult result;
+};
+
+int main(int argc, char* argv[]) {
+  if(argc != 7 && argc != 8) {
+    std::cout << "eviction-sweep <cache-configs> <traverse-cfgs> target-cache-level candidate-sizes splits total-tests [threads]" << std::endl;
+    std::cout << "               lists are comma separated, every combination is run once" << std::endl;
+    std::cout << "               with its searches split into shards of " << shard_trials << " seeded by the traverse seed + shard" << std::endl;
+    return 0;
+  }
+
+  std::vector<std::string> cache_names = split_list(argv[1]);
+  std::vector<std::string> traverse_names = split_list(argv[2]);
+  int cache_level = std::stoi(std::string(argv[3]));
+  std::vector<std::string> sizes = split_list(argv[4]);
+  std::vector<std::string> splits = split_list(argv[5]);
+  uint32_t testN = std::stoi(std::string(argv[6]));
+  uint32_t nthread = argc == 8 ? std::stoi(std::string(argv[7])) : std::thread::hardware_concurrency();
+  if(nthread == 0) nthread = 1;
+
+  // every config is parsed once and shared read-only by all jobs
+  std::vector<CacheCFG> ccfgs;
+  std::vector<TraverseTestCFG> tcfgs;
+  std::vector<traverse_func_t> traverse_funcs;
+  if(!cache_config_parser("config/cache.json", cache_names, &ccfgs)) return 1;
+  if(!traverse_config_parser("config/traverse.json", traverse_names, &tcfgs, &traverse_funcs)) return 1;
+
+  // the pools are not copyable, create all jobs at once
+  std::vector<SweepJob> jobs(cache_names.size() * traverse_names.size() * sizes.size() * splits.size());
+  std::vector<SweepShard> shards;
+  uint32_t j = 0;
+  for(uint32_t c=0; c<cache_names.size(); c++)
+    for(uint32_t t=0; t<traverse_names.size(); t++)
+      for(auto &size : sizes)
+        for(auto &split : splits) {
+          SweepJob &job = jobs[j];
+          job.cache = c; job.traverse = t;
+          job.candidate_size = std::stoi(size);
+          job.split = std::stoi(split);
+          for(uint32_t k=0; k*shard_trials < testN; k++) {
+            SweepShard shard;
+            shard.job = j;
+            shard.index = k;
+            shard.trials = std::min(shard_trials, testN - k*shard_trials);
+            shards.push_back(shard);
+          }
+          j++;
+        }
+
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for(size_t i = next++; i < shards.size(); i = next++) {
+      SweepShard &shard = shards[i];
+      SweepJob &job = jobs[shard.job];
+      TraverseTestCFG tcfg = tcfgs[job.traverse];
+      tcfg.seed += shard.index;
+      eviction_trial(ccfgs[job.cache], tcfg, traverse_funcs[job.traverse],
+                     cache_level, job.candidate_size, job.split, shard.trials, &shard.result, &job.pool);
+    }
+  };
+  std::vector<std::thread> threads;
+  for(uint32_t i=0; i<nthread && i<shards.size(); i++) threads.push_back(std::thread(worker));
+  for(auto &t : threads) t.join();
+  for(auto &shard : shards) jobs[shard.job].evict_dist.merge(shard.result.evict_dist);
+
+  const double qs[] = {0.5, 0.9, 0.99, 0.999};
+  std::cout << "cache\ttraverse\tcandidate\tsplit\ttests\tfound\tfull-mean\tfull-error\tevict-mean\tevict-error\tevict-p50\tevict-p90\tevict-p99\tevict-p99.9" << std::endl;
+  for(auto &job : jobs) {
+    std::cout << cache_names[job.cache] << "\t"
+              << traverse_names[job.traverse] << "\t"
+              << job.candidate_size << "\t"
+              << job.split << "\t"
+              << testN << "\t"
+              << job.pool.full.count() << "\t"
+              << job.pool.full.mean() << "\t"
+              << job.pool.full.error() << "\t"
+              << job.pool.evict.mean() << "\t"
+              << job.pool.evict.error();
+    for(auto q : qs) std::cout << "\t" << job.evict_dist.quantile(q);
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
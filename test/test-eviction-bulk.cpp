@@ -0,0 +1,77 @@
+#include "test/common.hpp"
+
+traverse_test_t target_traverse(uint64_t addr, L1CacheBase *cache, uint32_t level, traverse_func_t traverse_func) {
+  CacheBase *c = get_target_cache(addr, cache, level).cache;
+  return traverse_test(traverse_func, std::bind(query_hit, std::placeholders::_1, c),
+                       tcfg.ntests, tcfg.ntraverse, tcfg.threshold);
+}
+
+hit_func_t target_hit(uint64_t addr, L1CacheBase *cache, uint32_t level) {
+  CacheBase *c = get_target_cache(addr, cache, level).cache;
+  return std::bind(query_hit, std::placeholders::_1, c);
+}
+
+check_func_t target_check(uint64_t addr, L1CacheBase *cache, uint32_t level) {
+  CacheBase *c = get_target_cache(addr, cache, level).cache;
+  return std::bind(query_check, addr, c, std::placeholders::_1);
+}
+
+int main(int argc, char* argv[]) {
+  if(argc != 7) {
+    for(int i=0; i<argc; i++) std::cout << argv[i] << " ";
+    std::cout << std::endl;
+    std::cout << "test_eviction_bulk  <cache-config> <traverse-cfg> target-cache-level pool-size split targets" << std::endl;
+    return 0;
+  }
+
+  int cache_level = std::stoi(std::string(argv[3]));
+  int pool_size = std::stoi(std::string(argv[4]));
+  int splitN = std::stoi(std::string(argv[5]));
+  uint32_t targetN = std::stoi(std::string(argv[6]));
+
+  if(!cache_config_parser("config/cache.json", argv[1], &ccfg)) return 1;
+  traverse_func_t traverse_func = traverse_config_parser("config/traverse.json", argv[2], &tcfg);
+
+  cache_init();
+
+  L1CacheBase *entry = (L1CacheBase *)l1_caches[0];
+
+  PageMap *pmap = tcfg.page_size ? new PageMap(tcfg.page_size, tcfg.page_map == "random", &rng) : NULL;
+  candidate_gen_t candidate_gen = pmap ? page_candidate(pmap) : random_candidate(&rng);
+
+  // targets and the pool are generated at the same page offset when pages are modelled
+  uint64_t offset = get_random_uint64(1ull << 60, &rng);
+  std::list<uint64_t> target_list, pool;
+  candidate_gen(target_list, targetN, offset);
+  candidate_gen(pool, pool_size, offset);
+  std::vector<uint64_t> targets(target_list.begin(), target_list.end());
+  std::vector<std::list<uint64_t> > evict_sets;
+
+  reporter.clear();
+  if(cache_level == 1) reporter.register_cache_access_tracer(1, 0, 0);
+  else                 reporter.register_cache_access_tracer(2);
+
+  uint32_t found = targeted_bulk_search(entry, targets, pool, evict_sets,
+                                        std::bind(target_traverse, std::placeholders::_1, entry, cache_level, traverse_func),
+                                        std::bind(target_check, std::placeholders::_1, entry, cache_level),
+                                        std::bind(target_hit, std::placeholders::_1, entry, cache_level),
+                                        splitN, &rng);
+
+  double access = (cache_level == 1) ?
+    (double)(reporter.check_cache_access(1, 0, 0)) :
+    (double)(reporter.check_cache_access(2)) ;
+
+  std::unordered_set<uint64_t> classes;
+  for(auto &e : evict_sets) if(!e.empty()) classes.insert(e.front());
+
+  std::cout << pool_size << "\t"
+            << targetN << "\t"
+            << found << "\t"
+            << classes.size() << "\t"
+            << access << "\t"
+            << (found ? access / found : 0.0) << std::endl;
+
+  delete pmap;
+  cache_release();
+  return 0;
+}
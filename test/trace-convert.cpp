@@ -0,0 +1,44 @@
+#include "util/trace_import.hpp"
+#include "util/trace_delta.hpp"
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+  if(argc != 4 && argc != 5) {
+    std::cerr << "Usage: trace-convert <champsim|pin|spike|native|delta> <input-trace> <output-trace> [native|delta|delta-bytes]" << std::endl;
+    std::cerr << "       delta keeps line addresses only (the offset within a 64B line is lost), delta-bytes keeps byte addresses" << std::endl;
+    return 1;
+  }
+  std::string format = argc == 5 ? argv[4] : "native";
+  bool delta = format == "delta" || format == "delta-bytes";
+
+  TraceStream stream;
+  if(!stream.open(argv[2], argv[1])) {
+    std::cerr << "Fail to open " << argv[1] << " trace " << argv[2] << std::endl;
+    return 1;
+  }
+  TraceWriter writer;
+  DeltaTraceWriter delta_writer;
+  if(delta ? !delta_writer.open(argv[3], "", format == "delta-bytes") : !writer.open(argv[3])) {
+    std::cerr << "Fail to create trace " << argv[3] << std::endl;
+    return 1;
+  }
+
+  const TraceRecord *records;
+  size_t n;
+  uint64_t total = 0;
+  while(stream.next(&records, &n)) {
+    for(size_t i=0; i<n; i++)
+      if(delta) delta_writer.write(records[i].core, records[i].op, records[i].addr);
+      else      writer.write(records[i].core, records[i].op, records[i].addr);
+    total += n;
+  }
+
+  bool written = delta ? delta_writer.close() : writer.close();
+  stream.close();
+  if(!written) {
+    std::cerr << "Fail to write trace " << argv[3] << std::endl;
+    return 1;
+  }
+  std::cout << total << std::endl;
+  return 0;
+}
@@ -0,0 +1,44 @@
+#include "test/common.hpp"
+#include "util/trace.hpp"
+#include "util/threaded_sim.hpp"
+#include <chrono>
+
+int main(int argc, char* argv[]) {
+  if(argc != 3 && argc != 4) {
+    std::cerr << "Usage: trace-replay-mt <cache-config> <trace-file> [ordered]" << std::endl;
+    std::cerr << "       replay with one thread per core, `ordered' for the deterministic mode" << std::endl;
+    std::cerr << "       (a single hierarchy-wide lock: only L1-local accesses of different cores run in parallel)" << std::endl;
+    return 1;
+  }
+
+  if(!cache_config_parser("config/cache.json", argv[1], &ccfg)) return 1;
+  cache_init();
+
+  TraceFile trace;
+  if(!trace.open(argv[2])) {
+    std::cerr << "Fail to open trace " << argv[2] << std::endl;
+    return 1;
+  }
+
+  ThreadedHierarchy sim(l1_caches);
+  auto start = std::chrono::steady_clock::now();
+  uint64_t n = sim.replay(trace.data(), trace.size(), argc == 4 && std::string(argv[3]) == "ordered");
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  uint64_t access = 0, miss = 0, local = 0;
+  for(uint32_t i=0; i<l1_caches.size(); i++) {
+    access += sim.get_counters(i).access;
+    miss   += sim.get_counters(i).miss;
+    local  += sim.get_counters(i).local;
+  }
+  std::cout << n << "\t"
+            << access << "\t"
+            << miss << "\t"
+            << local << "\t"
+            << secs << "\t"
+            << n / secs / 1e6 << std::endl;
+
+  trace.close();
+  cache_release();
+  return 0;
+}
@@ -0,0 +1,50 @@
+#include "test/common.hpp"
+#include "util/trace.hpp"
+#include "util/parallel_sim.hpp"
+#include <chrono>
+
+int main(int argc, char* argv[]) {
+  if(argc != 4) {
+    std::cerr << "Usage: trace-replay-sets <cache-config> <trace-file> <threads>" << std::endl;
+    std::cerr << "       simulate the last cache level of the config alone, partitioned by sets across threads" << std::endl;
+    return 1;
+  }
+
+  if(!cache_config_parser("config/cache.json", argv[1], &ccfg)) return 1;
+  int level = ccfg.enable[1] ? 1 : 0;
+
+  TraceFile trace;
+  if(!trace.open(argv[2])) {
+    std::cerr << "Fail to open trace " << argv[2] << std::endl;
+    return 1;
+  }
+
+  ParallelCacheSim sim(atoi(argv[3]), ccfg.number[level], ccfg.cache_gen[level],
+                       level > 0 ? ccfg.hash_gen[level-1] : LLCHashNorm::gen(), level+1);
+  auto start = std::chrono::steady_clock::now();
+  uint64_t n = sim.replay(trace.data(), trace.size());
+  sim.finish();
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  auto cnt = sim.counters();
+  std::cout << n << "\t"
+            << cnt.access << "\t"
+            << cnt.miss << "\t"
+            << cnt.writeback << "\t"
+            << secs << "\t"
+            << n / secs / 1e6 << std::endl;
+
+  // with set sampling: estimated misses and miss rate with 95% confidence intervals
+  SampledRatioStat miss_rate;
+  uint64_t total = sim.sample_estimate(&miss_rate);
+  if(miss_rate.count()) {
+    auto ci = miss_rate.interval();
+    std::cout << boost::format("sampled %1% sets: %2% accesses, %3% misses [%4%, %5%], miss rate %6% [%7%, %8%]")
+      % miss_rate.count() % total
+      % (uint64_t)(miss_rate.ratio() * total) % (uint64_t)std::max(0.0, ci.first * total) % (uint64_t)(ci.second * total)
+      % miss_rate.ratio() % ci.first % ci.second << std::endl;
+  }
+
+  trace.close();
+  return 0;
+}
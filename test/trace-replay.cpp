@@ -0,0 +1,53 @@
+#include "test/common.hpp"
+#include "util/trace.hpp"
+#include "util/trace_import.hpp"
+#include "util/replay.hpp"
+#include <chrono>
+
+int main(int argc, char* argv[]) {
+  if(argc != 3 && argc != 4) {
+    std::cerr << "Usage: trace-replay <cache-config> <trace-file> [champsim|pin|spike|native|delta]" << std::endl;
+    std::cerr << "       a native trace is memory-mapped unless its format is given" << std::endl;
+    return 1;
+  }
+
+  if(!cache_config_parser("config/cache.json", argv[1], &ccfg)) return 1;
+  cache_init();
+
+  TraceFile trace;
+  TraceStream stream;
+  if(argc == 3 ? !trace.open(argv[2]) : !stream.open(argv[2], argv[3])) {
+    std::cerr << "Fail to open trace " << argv[2] << std::endl;
+    return 1;
+  }
+
+  reporter.register_cache_access_tracer(1);
+  auto start = std::chrono::steady_clock::now();
+  uint64_t n = argc == 3 ? trace_replay(trace.data(), trace.size(), l1_caches) : trace_replay(stream, l1_caches);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << n << "\t"
+            << reporter.check_cache_access(1) << "\t"
+            << reporter.check_cache_miss(1) << "\t"
+            << secs << "\t"
+            << n / secs / 1e6 << std::endl;
+
+  // levels simulated with set sampling: estimated misses and miss rate with 95% confidence intervals
+  std::vector<CoherentCache *> *levels[2] = {&l1_caches, &l2_caches};
+  for(int l=0; l<2; l++) {
+    SampledRatioStat miss_rate;
+    uint64_t total = 0;
+    for(auto c : *levels[l]) total += c->sample_estimate(&miss_rate);
+    if(miss_rate.count() == 0) continue;
+    auto ci = miss_rate.interval();
+    std::cout << boost::format("L%1% sampled %2% sets: %3% accesses, %4% misses [%5%, %6%], miss rate %7% [%8%, %9%]")
+      % (l+1) % miss_rate.count() % total
+      % (uint64_t)(miss_rate.ratio() * total) % (uint64_t)std::max(0.0, ci.first * total) % (uint64_t)(ci.second * total)
+      % miss_rate.ratio() % ci.first % ci.second << std::endl;
+  }
+
+  trace.close();
+  stream.close();
+  cache_release();
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include "test/common.hpp"
+#include "util/trace.hpp"
+#include "util/replay.hpp"
+#include "util/sweep.hpp"
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+  if(argc < 5) {
+    std::cerr << "Usage: trace-sweep <cache-config> <trace-file> <sample> <set>x<way> [<set>x<way> ...]" << std::endl;
+    std::cerr << "       replay a trace on the config and sweep LRU configurations over the access stream of its last level" << std::endl;
+    std::cerr << "       (core 0 of L1 or slice 0 of the LLC), simulating about 1/sample of the sets" << std::endl;
+    return 1;
+  }
+
+  if(!cache_config_parser("config/cache.json", argv[1], &ccfg)) return 1;
+
+  LRUSweep sweep(IndexNorm::gen(), atoi(argv[3]));
+  for(int i=4; i<argc; i++) {
+    uint32_t nset, nway;
+    if(sscanf(argv[i], "%ux%u", &nset, &nway) != 2 || nset == 0 || nway == 0) {
+      std::cerr << "Wrong configuration " << argv[i] << std::endl;
+      return 1;
+    }
+    sweep.add_config(nset, nway);
+  }
+
+  TraceFile trace;
+  if(!trace.open(argv[2])) {
+    std::cerr << "Fail to open trace " << argv[2] << std::endl;
+    return 1;
+  }
+
+  cache_init();
+  uint32_t level = ccfg.enable[1] ? 2 : 1;
+  int32_t core_id = level == 1 ? 0 : -1;
+  sweep.monitor(level, core_id, 0);
+  reporter.attach_monitor(&sweep);
+  reporter.register_cache_access_tracer(level, core_id, 0);
+  trace_replay(trace.data(), trace.size(), l1_caches);
+  reporter.detach_monitor(&sweep);
+
+  // the simulated cache first, then the swept configurations: set way access hit miss evict
+  std::cout << boost::format("%1%: %2% %3% %4% %5% %6% %7%")
+    % argv[1] % ccfg.nset[level-1] % ccfg.nway[level-1]
+    % reporter.check_cache_access(level, core_id, 0) % reporter.check_cache_hit(level, core_id, 0)
+    % reporter.check_cache_miss(level, core_id, 0) % reporter.check_cache_evict(level, core_id, 0) << std::endl;
+  std::cout << sweep.to_string();
+
+  trace.close();
+  cache_release();
+  return 0;
+}
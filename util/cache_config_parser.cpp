@@ -9,6 +9,14 @@ using json = nlohmann::json;
 
 #define MAX_RECUR_LEVEL 40
 
+// errors go to std::cerr unless the caller of the parser asks for them
+static thread_local std::string *error_sink = NULL;
+
+static void config_error(const std::string &msg) {
+  if(error_sink) *error_sink = msg;
+  else           std::cerr << msg << std::endl;
+}
+
 template<typename T>
 inline void obtain_config(T& rv, const json &db, const std::string &label, const std::string &ctype, const std::string &param) {
   if(db[label][ctype].count(param)) rv = db[label][ctype][param].get<T>();
@@ -22,16 +30,20 @@ public:
   IndexCFGLoc(): ctype("norm"), delay(0), creator(IndexNorm::gen()) {}
 };
 
-void indexer_config_decoder(IndexCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
+bool indexer_config_decoder(IndexCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
   if(t > MAX_RECUR_LEVEL) {
-    std::cerr << boost::format("Recursive more than %1% times when trying to decode index configuration %2%" ) % MAX_RECUR_LEVEL % ctype << std::endl;
-    return;
+    config_error((boost::format("Recursive more than %1% times when trying to decode index configuration %2%" ) % MAX_RECUR_LEVEL % ctype).str());
+    return false;
   }
 
-  assert(db["indexer"].count(ctype));
+  if(!db.count("indexer") || !db["indexer"].count(ctype)) {
+    config_error((boost::format("Fail to find the index configuration `%1%'.") % ctype).str());
+    return false;
+  }
 
-  if(db["indexer"][ctype].count("base"))
-    indexer_config_decoder(cfg, db, db["indexer"][ctype]["base"].get<std::string>(), t+1);
+  if(db["indexer"][ctype].count("base") &&
+     !indexer_config_decoder(cfg, db, db["indexer"][ctype]["base"].get<std::string>(), t+1))
+    return false;
 
   obtain_config(cfg->ctype,       db, "indexer", ctype, "type"       );
   obtain_config(cfg->delay,       db, "indexer", ctype, "delay"      );
@@ -39,6 +51,7 @@ void indexer_config_decoder(IndexCFGLoc *cfg, const json &db, const std::string
   if(t == 0) { // the end of recursively calls
     if     (cfg->ctype == "norm"  ) cfg->creator = IndexNorm::gen(cfg->delay);
   }
+  return true;
 }
 
 class TagCFGLoc {
@@ -49,16 +62,20 @@ public:
   TagCFGLoc(): ctype("norm"), delay(0), creator(TagNorm::gen()) {}
 };
 
-void tagger_config_decoder(TagCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
+bool tagger_config_decoder(TagCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
   if(t > MAX_RECUR_LEVEL) {
-    std::cerr << boost::format("Recursive more than %1% times when trying to decode tagger configuration %2%" ) % MAX_RECUR_LEVEL % ctype << std::endl;
-    return;
+    config_error((boost::format("Recursive more than %1% times when trying to decode tagger configuration %2%" ) % MAX_RECUR_LEVEL % ctype).str());
+    return false;
   }
 
-  assert(db["tagger"].count(ctype));
+  if(!db.count("tagger") || !db["tagger"].count(ctype)) {
+    config_error((boost::format("Fail to find the tagger configuration `%1%'.") % ctype).str());
+    return false;
+  }
 
-  if(db["tagger"][ctype].count("base"))
-    tagger_config_decoder(cfg, db, db["tagger"][ctype]["base"].get<std::string>(), t+1);
+  if(db["tagger"][ctype].count("base") &&
+     !tagger_config_decoder(cfg, db, db["tagger"][ctype]["base"].get<std::string>(), t+1))
+    return false;
 
   obtain_config(cfg->ctype, db, "tagger", ctype, "type" );
   obtain_config(cfg->delay, db, "tagger", ctype, "delay");
@@ -66,6 +83,7 @@ void tagger_config_decoder(TagCFGLoc *cfg, const json &db, const std::string &ct
   if(t == 0) { // the end of recursively calls
     if     (cfg->ctype == "norm"  ) cfg->creator = TagNorm::gen();
   }
+  return true;
 }
 
 class ReplaceCFGLoc {
@@ -73,32 +91,39 @@ public:
   std::string ctype;
   uint32_t delay;
   uint32_t width;
+  uint64_t seed;
   replacer_creator_t creator;
-  ReplaceCFGLoc(): ctype("lru"), delay(0), width(0), creator(ReplaceLRU::gen()) {}
+  ReplaceCFGLoc(): ctype("lru"), delay(0), width(0), seed(0), creator(ReplaceLRU::gen()) {}
 };
 
-void replacer_config_decoder(ReplaceCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
+bool replacer_config_decoder(ReplaceCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
   if(t > MAX_RECUR_LEVEL) {
-    std::cerr << boost::format("Recursive more than %1% times when trying to decode replacer configuration %2%" ) % MAX_RECUR_LEVEL % ctype << std::endl;
-    return;
+    config_error((boost::format("Recursive more than %1% times when trying to decode replacer configuration %2%" ) % MAX_RECUR_LEVEL % ctype).str());
+    return false;
   }
 
-  assert(db["replacer"].count(ctype));
+  if(!db.count("replacer") || !db["replacer"].count(ctype)) {
+    config_error((boost::format("Fail to find the replacer configuration `%1%'.") % ctype).str());
+    return false;
+  }
 
-  if(db["replacer"][ctype].count("base"))
-    replacer_config_decoder(cfg, db, db["replacer"][ctype]["base"].get<std::string>(), t+1);
+  if(db["replacer"][ctype].count("base") &&
+     !replacer_config_decoder(cfg, db, db["replacer"][ctype]["base"].get<std::string>(), t+1))
+    return false;
 
   obtain_config(cfg->ctype, db, "replacer", ctype, "type" );
   obtain_config(cfg->delay, db, "replacer", ctype, "delay");
   obtain_config(cfg->width, db, "replacer", ctype, "width");
+  obtain_config(cfg->seed,  db, "replacer", ctype, "seed" );
 
   if(t == 0) { // the end of recursively calls
     if     (cfg->ctype == "norm"  ) cfg->creator = ReplaceLRU::gen(cfg->delay);
     else if(cfg->ctype == "lru"   ) cfg->creator = ReplaceLRU::gen(cfg->delay);
-    else if(cfg->ctype == "random") cfg->creator = ReplaceRandom::gen(cfg->delay);
+    else if(cfg->ctype == "random") cfg->creator = ReplaceRandom::gen(cfg->delay, cfg->seed);
     else if(cfg->ctype == "fifo"  ) cfg->creator = ReplaceFIFO::gen(cfg->delay);
     else if(cfg->ctype == "rrip"  ) cfg->creator = ReplaceRRIP::gen(cfg->width, cfg->delay);
   }
+  return true;
 }
 
 class HashCFGLoc {
@@ -109,16 +134,20 @@ public:
   HashCFGLoc(): ctype("norm"), delay(0), creator(LLCHashNorm::gen()) {}
 };
 
-void hasher_config_decoder(HashCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
+bool hasher_config_decoder(HashCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
   if(t > MAX_RECUR_LEVEL) {
-    std::cerr << boost::format("Recursive more than %1% times when trying to decode hasher configuration %2%" ) % MAX_RECUR_LEVEL % ctype << std::endl;
-    return;
+    config_error((boost::format("Recursive more than %1% times when trying to decode hasher configuration %2%" ) % MAX_RECUR_LEVEL % ctype).str());
+    return false;
   }
 
-  assert(db["hasher"].count(ctype));
+  if(!db.count("hasher") || !db["hasher"].count(ctype)) {
+    config_error((boost::format("Fail to find the hasher configuration `%1%'.") % ctype).str());
+    return false;
+  }
 
-  if(db["hasher"][ctype].count("base"))
-    hasher_config_decoder(cfg, db, db["hasher"][ctype]["base"].get<std::string>(), t+1);
+  if(db["hasher"][ctype].count("base") &&
+     !hasher_config_decoder(cfg, db, db["hasher"][ctype]["base"].get<std::string>(), t+1))
+    return false;
 
   obtain_config(cfg->ctype, db, "hasher", ctype, "type" );
   obtain_config(cfg->delay, db, "hasher", ctype, "delay");
@@ -127,6 +156,7 @@ void hasher_config_decoder(HashCFGLoc *cfg, const json &db, const std::string &c
     if     (cfg->ctype == "norm"  ) cfg->creator = LLCHashNorm::gen();
     else if(cfg->ctype == "hash"  ) cfg->creator = LLCHashHash::gen();
   }
+  return true;
 }
 
 class CacheCFGLoc {
@@ -136,6 +166,7 @@ public:
   uint32_t number;
   uint32_t nset;
   uint32_t nway;
+  uint32_t sample;
   std::string indexer;
   std::string tagger;
   std::string replacer;
@@ -143,59 +174,86 @@ public:
   cache_creator_t creator;
   CacheCFGLoc()
     : ctype("norm"), delay(0),
-      number(1), nset(64), nway(8),
+      number(1), nset(64), nway(8), sample(1),
       indexer("norm"), tagger("norm"), replacer("lru"), hasher("norm") {} 
 };
 
-void cache_config_decoder(CacheCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
+bool cache_config_decoder(CacheCFGLoc *cfg, const json &db, const std::string &ctype, int t = 0) {
   if(t > MAX_RECUR_LEVEL) {
-    std::cerr << boost::format("Recursive more than %1% times when trying to decode cache configuration %2%" ) % MAX_RECUR_LEVEL % ctype << std::endl;
-    return;
+    config_error((boost::format("Recursive more than %1% times when trying to decode cache configuration %2%" ) % MAX_RECUR_LEVEL % ctype).str());
+    return false;
   }
 
-  assert(db["cache"].count(ctype));
+  if(!db.count("cache") || !db["cache"].count(ctype)) {
+    config_error((boost::format("Fail to find the cache configuration `%1%'.") % ctype).str());
+    return false;
+  }
 
-  if(db["cache"][ctype].count("base"))
-    cache_config_decoder(cfg, db, db["cache"][ctype]["base"].get<std::string>(), t+1);
+  if(db["cache"][ctype].count("base") &&
+     !cache_config_decoder(cfg, db, db["cache"][ctype]["base"].get<std::string>(), t+1))
+    return false;
 
   obtain_config(cfg->ctype,    db, "cache", ctype, "type"     );
   obtain_config(cfg->delay,    db, "cache", ctype, "delay"    );
   obtain_config(cfg->number,   db, "cache", ctype, "number"   );
   obtain_config(cfg->nset,     db, "cache", ctype, "set"      );
   obtain_config(cfg->nway,     db, "cache", ctype, "way"      );
+  obtain_config(cfg->sample,   db, "cache", ctype, "sample"   );
   obtain_config(cfg->indexer,  db, "cache", ctype, "indexer"  );
   obtain_config(cfg->tagger,   db, "cache", ctype, "tagger"   );
   obtain_config(cfg->replacer, db, "cache", ctype, "replacer" );
   obtain_config(cfg->hasher,   db, "cache", ctype, "hasher"   );
 
   if(t == 0) { // the end of recursively calls
-    IndexCFGLoc   index_config;   indexer_config_decoder(  &index_config,   db, cfg->indexer );
-    TagCFGLoc     tag_config;     tagger_config_decoder(   &tag_config,     db, cfg->tagger  );
-    ReplaceCFGLoc replace_config; replacer_config_decoder( &replace_config, db, cfg->replacer);
+    IndexCFGLoc   index_config;
+    TagCFGLoc     tag_config;
+    ReplaceCFGLoc replace_config;
+    if(!indexer_config_decoder(  &index_config,   db, cfg->indexer ) ||
+       !tagger_config_decoder(   &tag_config,     db, cfg->tagger  ) ||
+       !replacer_config_decoder( &replace_config, db, cfg->replacer))
+      return false;
 
     if(cfg->ctype == "norm"  )
-      cfg->creator = CacheBase::gen(cfg->nset, cfg->nway, index_config.creator, tag_config.creator, replace_config.creator, cfg->delay);
+      cfg->creator = CacheBase::gen(cfg->nset, cfg->nway, index_config.creator, tag_config.creator, replace_config.creator, cfg->delay, cfg->sample);
+    else {
+      config_error((boost::format("Unsupported cache type `%1%' of cache configuration %2%.") % cfg->ctype % ctype).str());
+      return false;
+    }
   }
+  return true;
 }
 
-bool cache_config_parser(const std::string& fn, const std::string& cfg, CacheCFG *ccfg) {
-  json db;
+static bool cache_config_load(const std::string& fn, json *db) {
   std::ifstream db_file(fn);
   if(db_file.good()) {
-    db_file >> db;
+    try {
+      db_file >> *db;
+    } catch(std::exception &e) {
+      config_error((boost::format("Fail to parse config file `%1%': %2%") % fn % e.what()).str());
+      return false;
+    }
     db_file.close();
-    //std::cout << db.dump(4) << std::endl;
+    //std::cout << db->dump(4) << std::endl;
+    return true;
   } else {
-    std::cerr << boost::format("Fail to open config file `%1%") % fn << std::endl;
+    config_error((boost::format("Fail to open config file `%1%'.") % fn).str());
     return false;
   }
+}
 
+static bool cache_config_decode(const json &db, const std::string& cfg, CacheCFG *ccfg) {
   if(!db.count("config") || !db["config"].count(cfg)) {
-    std::cerr << boost::format("Fail to find the specific config `%1%'. ") % cfg << std::endl;
+    config_error((boost::format("Fail to find the specific config `%1%'. ") % cfg).str());
     return false;
   }
 
-  std::vector<std::string> cache_cfgs = db["config"][cfg].get< std::vector<std::string> >();
+  std::vector<std::string> cache_cfgs;
+  try {
+    cache_cfgs = db["config"][cfg].get< std::vector<std::string> >();
+  } catch(std::exception &e) {
+    config_error((boost::format("Config `%1%' is not a list of cache configurations: %2%") % cfg % e.what()).str());
+    return false;
+  }
 
   for(int level = 0; level < 2; level++) {
     if(level >= cache_cfgs.size()) {
@@ -205,8 +263,11 @@ bool cache_config_parser(const std::string& fn, const std::string& cfg, CacheCFG
 
     std::string ctype = cache_cfgs[level];
 
-    CacheCFGLoc   cache_config;   cache_config_decoder(    &cache_config,   db, ctype               );
-    HashCFGLoc    hash_config;    hasher_config_decoder(   &hash_config,    db, cache_config.hasher );
+    CacheCFGLoc   cache_config;
+    HashCFGLoc    hash_config;
+    if(!cache_config_decoder(  &cache_config, db, ctype               ) ||
+       !hasher_config_decoder( &hash_config,  db, cache_config.hasher ))
+      return false;
 
     ccfg->number[level] = cache_config.number;
     ccfg->cache_gen[level] = cache_config.creator;
@@ -218,3 +279,51 @@ bool cache_config_parser(const std::string& fn, const std::string& cfg, CacheCFG
 
   return true;
 }
+
+// values of a wrong json type throw from get<>()
+static bool cache_config_decode_safe(const json &db, const std::string& cfg, CacheCFG *ccfg) {
+  try {
+    return cache_config_decode(db, cfg, ccfg);
+  } catch(std::exception &e) {
+    config_error((boost::format("Fail to decode config `%1%': %2%") % cfg % e.what()).str());
+    return false;
+  }
+}
+
+bool cache_config_parser(const std::string& fn, const std::string& cfg, CacheCFG *ccfg, std::string *error) {
+  json db;
+  error_sink = error;
+  bool rv = cache_config_load(fn, &db) && cache_config_decode_safe(db, cfg, ccfg);
+  error_sink = NULL;
+  return rv;
+}
+
+bool cache_config_parser(const std::string& fn, const std::vector<std::string>& cfgs, std::vector<CacheCFG> *ccfgs, std::string *error) {
+  json db;
+  error_sink = error;
+  bool rv = cache_config_load(fn, &db);
+  if(rv) {
+    ccfgs->resize(cfgs.size());
+    for(size_t i=0; rv && i<cfgs.size(); i++)
+      rv = cache_config_decode_safe(db, cfgs[i], &(*ccfgs)[i]);
+  }
+  error_sink = NULL;
+  return rv;
+}
+
+void build_hierarchy(const CacheCFG &ccfg, std::vector<CoherentCache *> *l1_caches, std::vector<CoherentCache *> *l2_caches) {
+  l1_caches->resize(ccfg.number[0]);
+  l2_caches->resize(ccfg.enable[1] ? ccfg.number[1] : 0);
+  for(int i=0; i<ccfg.number[0]; i++)
+    (*l1_caches)[i] = new L1CacheBase(i, i, 0, ccfg.cache_gen[0], ccfg.enable[1] ? l2_caches : NULL, ccfg.hash_gen[0]);
+  if(ccfg.enable[1])
+    for(int i=0; i<ccfg.number[1]; i++)
+      (*l2_caches)[i] = new LLCCacheBase(i, 2, ccfg.cache_gen[1], l1_caches);
+}
+
+void release_hierarchy(std::vector<CoherentCache *> *l1_caches, std::vector<CoherentCache *> *l2_caches) {
+  for(auto c : *l1_caches) delete c;
+  for(auto c : *l2_caches) delete c;
+  l1_caches->clear();
+  l2_caches->clear();
+}
@@ -3,6 +3,7 @@
 
 #include "cache/definitions.hpp"
 #include <string>
+#include <vector>
 const int MAX_CACHE_LEVEL = 2;
 
 struct CacheCFG {
@@ -15,7 +16,15 @@ struct CacheCFG {
   uint32_t nway[MAX_CACHE_LEVEL];
 };
 
-extern bool cache_config_parser(const std::string& fn, const std::string& cfg, CacheCFG *ccfg);
+// errors are printed to std::cerr, or stored in `error' when it is given
+extern bool cache_config_parser(const std::string& fn, const std::string& cfg, CacheCFG *ccfg, std::string *error = NULL);
+// decode multiple configs with a single read of the config file
+extern bool cache_config_parser(const std::string& fn, const std::vector<std::string>& cfgs, std::vector<CacheCFG> *ccfgs, std::string *error = NULL);
+
+// create the hierarchy of a config: one L1 per core, and the L2 slices when enabled (`l2_caches' left empty otherwise)
+extern void build_hierarchy(const CacheCFG &ccfg, std::vector<CoherentCache *> *l1_caches, std::vector<CoherentCache *> *l2_caches);
+// delete the caches of a hierarchy created by build_hierarchy() and empty both lists
+extern void release_hierarchy(std::vector<CoherentCache *> *l1_caches, std::vector<CoherentCache *> *l2_caches);
 
 #endif
 
@@ -0,0 +1,87 @@
+#include "util/classify.hpp"
+#include <cassert>
+
+void ShadowLRU::unlink(uint32_t n) {
+  Node &node = nodes[n];
+  if(node.prev != nil) nodes[node.prev].next = node.next; else head = node.next;
+  if(node.next != nil) nodes[node.next].prev = node.prev; else tail = node.prev;
+}
+
+void ShadowLRU::push_front(uint32_t n) {
+  nodes[n].prev = nil;
+  nodes[n].next = head;
+  if(head != nil) nodes[head].prev = n; else tail = n;
+  head = n;
+}
+
+bool ShadowLRU::access(uint64_t addr) {
+  auto it = map.find(addr);
+  if(it != map.end()) {
+    if(it->second != head) {
+      unlink(it->second);
+      push_front(it->second);
+    }
+    return true;
+  }
+
+  uint32_t n;
+  if(nodes.size() < capacity) { // not full yet
+    n = nodes.size();
+    nodes.push_back(Node());
+  } else {                              // replace the LRU
+    n = tail;
+    unlink(n);
+    map.erase(nodes[n].addr);
+  }
+  nodes[n].addr = addr;
+  map[addr] = n;
+  push_front(n);
+  return false;
+}
+
+void ShadowLRU::clear() {
+  nodes.clear();
+  map.clear();
+  head = tail = nil;
+}
+
+void MissClassifier::track(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t nset, uint32_t nway) {
+  assert(!find_cache(caches, level, core_id, cache_id));
+  caches.insert(std::make_pair(cache_key(level, core_id, cache_id), CacheClass(nset, nway)));
+}
+
+void MissClassifier::access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit) {
+  CacheClass *cc = find_cache(caches, level, core_id, cache_id);
+  if(!cc) return;
+  CacheClass &c = *cc;
+  if(idx >= c.sets.size()) c.sets.resize(idx+1);
+  MissRecord &s = c.sets[idx];
+  bool shadow_hit = c.shadow.access(addr);
+  bool first = c.touched.insert(addr).second;
+  c.total.n_access++;
+  s.n_access++;
+  if(hit) return;
+  if(first)            { c.total.n_compulsory++; s.n_compulsory++; }
+  else if(!shadow_hit) { c.total.n_capacity++;   s.n_capacity++;   }
+  else                 { c.total.n_conflict++;   s.n_conflict++;   }
+}
+
+const MissRecord *MissClassifier::cache_record(uint32_t level, int32_t core_id, int32_t cache_id) const {
+  const CacheClass *c = find_cache(caches, level, core_id, cache_id);
+  return c ? &(c->total) : NULL;
+}
+
+const MissRecord *MissClassifier::set_record(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
+  const CacheClass *c = find_cache(caches, level, core_id, cache_id);
+  if(!c || idx >= c->sets.size()) return NULL;
+  return &(c->sets[idx]);
+}
+
+void MissClassifier::clear() {
+  for(auto &c : caches) {
+    c.second.shadow.clear();
+    c.second.touched.clear();
+    c.second.total = MissRecord();
+    for(auto &s : c.second.sets) s = MissRecord();
+  }
+}
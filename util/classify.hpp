@@ -0,0 +1,71 @@
+#ifndef UTIL_CLASSIFY_HPP_
+#define UTIL_CLASSIFY_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include "util/report.hpp"
+
+// fully-associative LRU of a fixed number of blocks
+//   blocks are kept in an intrusive list over a node pool and found by a hash map
+class ShadowLRU
+{
+  struct Node {
+    uint64_t addr;
+    uint32_t prev, next;
+  };
+  static const uint32_t nil = UINT32_MAX;
+
+  std::vector<Node> nodes;
+  std::unordered_map<uint64_t, uint32_t> map;
+  uint32_t head, tail;   // most and least recently used
+  uint32_t capacity;
+
+  void unlink(uint32_t n);
+  void push_front(uint32_t n);
+
+public:
+  ShadowLRU(uint32_t capacity) : head(nil), tail(nil), capacity(capacity) {
+    nodes.reserve(capacity);
+    map.reserve(capacity);
+  }
+  bool access(uint64_t addr);    // return whether it hits, the block becomes the MRU
+  void clear();
+};
+
+struct MissRecord {
+  uint64_t n_access;
+  uint64_t n_compulsory;
+  uint64_t n_capacity;
+  uint64_t n_conflict;
+  MissRecord() : n_access(0), n_compulsory(0), n_capacity(0), n_conflict(0) {}
+};
+
+// compulsory/capacity/conflict classification of the misses of traced caches
+//   a miss is compulsory on the first touch of a block, a capacity miss when it also misses in
+//   a fully-associative LRU of the same size, and a conflict miss otherwise
+class MissClassifier : public AccessMonitor
+{
+  struct CacheClass {
+    ShadowLRU shadow;
+    std::unordered_set<uint64_t> touched;
+    MissRecord total;
+    std::vector<MissRecord> sets;
+    CacheClass(uint32_t nset, uint32_t nway) : shadow(nset*nway), sets(nset) {}
+  };
+
+  std::unordered_map<uint64_t, CacheClass> caches;
+
+public:
+  virtual ~MissClassifier() {}
+  // nset and nway of the traced cache, accesses to sets beyond nset grow the per-set table
+  void track(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t nset, uint32_t nway);
+  virtual void access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit);
+
+  const MissRecord *cache_record(uint32_t level, int32_t core_id, int32_t cache_id) const;
+  const MissRecord *set_record(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const;
+  void clear();
+};
+
+#endif
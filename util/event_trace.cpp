@@ -0,0 +1,81 @@
+#include "util/event_trace.hpp"
+#include "util/stream.hpp"
+#include <cstring>
+#include <chrono>
+#include <boost/format.hpp>
+
+static const char event_magic[8] = {'C', 'M', 'E', 'V', 'T', '0', '0', '1'};
+
+std::string event_to_string(const EventRecord &r, bool with_time) {
+  std::string rv = with_time ? (boost::format("%1% ") % r.time).str() : std::string();
+  rv += (boost::format("0x%016x ") % r.addr).str();
+  switch(r.event) {
+  case EventRecord::ACCESS:
+    rv += (boost::format("is accessed at level %1% core %2% cache %3% set %4% way %5% [%6%]")
+           % (uint32_t)r.level % r.core_id % r.cache_id % r.idx % r.way % (uint32_t)r.state).str();
+    break;
+  case EventRecord::EVICT:
+    rv += (boost::format("is evicted at level %1% core %2% cache %3% set %4% way %5% [%6%]")
+           % (uint32_t)r.level % r.core_id % r.cache_id % r.idx % r.way % (uint32_t)r.state).str();
+    break;
+  case EventRecord::SET_ADD:
+    rv += (boost::format("is added to level %1% core %2% cache %3% set %4%")
+           % (uint32_t)r.level % r.core_id % r.cache_id % r.idx).str();
+    break;
+  case EventRecord::SET_EVICT:
+    rv += (boost::format("is evicted from level %1% core %2% cache %3% set %4%")
+           % (uint32_t)r.level % r.core_id % r.cache_id % r.idx).str();
+    break;
+  default:
+    rv += "unknown event";
+  }
+  return rv;
+}
+
+bool EventTraceWriter::open(const std::string &fn, const std::string &compress) {
+  close();
+  fp = open_stream(fn, true, &piped, compress);
+  if(!fp) return false;
+  fwrite(event_magic, sizeof(event_magic), 1, fp);
+  stop = false;
+  flusher = std::thread(&EventTraceWriter::flush_loop, this);
+  return true;
+}
+
+bool EventTraceWriter::close() {
+  if(!fp) return true;
+  stop = true;
+  flusher.join();
+  bool rv = close_stream(fp, piped);
+  fp = NULL;
+  return rv;
+}
+
+void EventTraceWriter::flush_loop() {
+  const size_t bulk = 4096;
+  EventRecord buf[bulk];
+  while(true) {
+    bool stopping = stop.load();  // check before draining so no record pushed before stop is lost
+    size_t n = ring.pop_bulk(buf, bulk);
+    if(n) fwrite(buf, sizeof(EventRecord), n, fp);
+    else if(stopping) break;
+    else std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+bool EventTraceReader::open(const std::string &fn) {
+  close();
+  fp = open_stream(fn, false, &piped);
+  if(!fp) return false;
+  char magic[sizeof(event_magic)];
+  if(fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, event_magic, sizeof(magic))) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void EventTraceReader::close() {
+  close_stream(fp, piped);
+  fp = NULL;
+}
@@ -0,0 +1,70 @@
+#ifndef UTIL_EVENT_TRACE_HPP_
+#define UTIL_EVENT_TRACE_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <atomic>
+#include "util/ring.hpp"
+
+// a binary record of a traced cache event
+struct EventRecord {
+  enum { ACCESS = 0, EVICT = 1, SET_ADD = 2, SET_EVICT = 3 };
+
+  uint64_t time;      // wall time, or the event sequence number when wall time is not set
+  uint64_t addr;
+  uint32_t idx;
+  uint16_t way;
+  int16_t  core_id;
+  int16_t  cache_id;
+  uint8_t  level;
+  uint8_t  event;
+  uint8_t  state;
+  uint8_t  pad[3];
+};
+
+static_assert(sizeof(EventRecord) == 32, "unexpected size of EventRecord");
+
+// the text form of an event, same as the messages printed by the reporter when no trace file is open
+extern std::string event_to_string(const EventRecord &r, bool with_time = true);
+
+// Events are pushed into a lock-free ring buffer and a background thread writes them to file.
+// The file is compressed by piping it through an external tool when `compress' is "zstd",
+// "lz4", "gzip" or "xz", or the file name ends with the matching extension.
+class EventTraceWriter
+{
+  SPSCRing<EventRecord> ring;
+  FILE *fp;
+  bool piped;
+  std::thread flusher;
+  std::atomic<bool> stop;
+
+  void flush_loop();
+
+public:
+  EventTraceWriter(size_t ring_size = 1 << 16) : ring(ring_size), fp(NULL), piped(false), stop(false) {}
+  ~EventTraceWriter() { close(); }
+
+  bool open(const std::string &fn, const std::string &compress = "");
+  bool close();   // false when the trace could not be written completely
+
+  void write(const EventRecord &r) {
+    while(!ring.push(r)) std::this_thread::yield();
+  }
+};
+
+// Read a trace generated by EventTraceWriter, compressed files are recognized by their extension.
+class EventTraceReader
+{
+  FILE *fp;
+  bool piped;
+public:
+  EventTraceReader() : fp(NULL), piped(false) {}
+  ~EventTraceReader() { close(); }
+  bool open(const std::string &fn);
+  void close();
+  bool read(EventRecord *r) { return fp && fread(r, sizeof(EventRecord), 1, fp) == 1; }
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "util/parallel_sim.hpp"
+#include "cache/cache.hpp"
+#include "util/report.hpp"
+#include <chrono>
+
+ParallelCacheSim::Counters &ParallelCacheSim::Counters::operator+=(const Counters &c) {
+  access += c.access; miss += c.miss; write += c.write;
+  evict += c.evict; writeback += c.writeback;
+  return *this;
+}
+
+// a slice of the simulated level (no inner or outer caches) counting its misses and evictions
+class ParallelCacheSim::Slice : public CoherentCache
+{
+  Counters *cnt;
+public:
+  Slice(uint32_t id, uint32_t level, cache_creator_t cc, Counters *cnt)
+    : CoherentCache(id, level, -1, id, cc), cnt(cnt) {}
+  const CacheBase *get_cache() const { return cache; }
+
+protected:
+  virtual void replace(uint64_t *latency, uint64_t addr, uint32_t *idx, uint32_t *way) {
+    cnt->miss++;
+    CoherentCache::replace(latency, addr, idx, way);
+  }
+  virtual void evict(uint64_t *latency, uint32_t idx, uint32_t way) {
+    uint64_t meta = cache->get_meta(NULL, idx, way);
+    if(!CM::is_invalid(meta)) {
+      cnt->evict++;
+      if(CM::is_dirty(meta)) cnt->writeback++;
+    }
+    CoherentCache::evict(latency, idx, way);
+  }
+};
+
+ParallelCacheSim::ParallelCacheSim(uint32_t nworker, uint32_t nslice, cache_creator_t cc, llc_hash_creator_t hc,
+                                   uint32_t level, uint32_t nbatch, size_t batch_size)
+  : nslice(nslice), batch_size(batch_size),
+    dispatch_cache(cc(level, -1, 0)), hasher(hc(nslice)), stop(false), filtered(0)
+{
+  nset = dispatch_cache->nset;
+  if(nworker == 0) nworker = 1;
+  for(uint32_t i=0; i<nworker; i++) {
+    Worker *w = new Worker(nbatch);
+    for(uint32_t s=0; s<nslice; s++) w->caches.push_back(new Slice(s, level, cc, &w->counters));
+    w->batches.resize(nbatch, std::vector<Item>(batch_size));
+    w->sizes.resize(nbatch, 0);
+    for(uint32_t b=0; b<nbatch; b++) w->free.push(b);
+    workers.push_back(std::unique_ptr<Worker>(w));
+  }
+  for(auto &w : workers) w->thread = std::thread(&ParallelCacheSim::work, this, w.get());
+}
+
+ParallelCacheSim::~ParallelCacheSim() {
+  finish();
+  stop = true;
+  for(auto &w : workers) {
+    w->thread.join();
+    for(auto c : w->caches) delete c;
+  }
+  delete dispatch_cache;
+  delete hasher;
+}
+
+void ParallelCacheSim::exec(Worker *w, const Item &it) {
+  Counters &cnt = w->counters;
+  uint64_t addr = CM::normalize(it.addr);
+  cnt.access++;
+  if(it.addr & 1) {
+    cnt.write++;
+    w->caches[it.slice]->write(NULL, addr, 0, true);
+  } else
+    w->caches[it.slice]->read(NULL, addr, 0);
+}
+
+void ParallelCacheSim::work(Worker *w) {
+  uint32_t i, backoff = 10;
+  while(true) {
+    if(!w->full.pop(i)) {
+      if(stop) break;
+      std::this_thread::sleep_for(std::chrono::microseconds(backoff));
+      backoff = std::min(backoff * 2, 2000u);
+      continue;
+    }
+    backoff = 10;
+    for(size_t k=0; k<w->sizes[i]; k++) exec(w, w->batches[i][k]);
+    w->processed.fetch_add(w->sizes[i], std::memory_order_release);
+    w->free.push(i);
+  }
+}
+
+// hand the batch being filled over to the worker
+void ParallelCacheSim::push(Worker *w) {
+  if(w->current < 0) return;
+  w->dispatched += w->sizes[w->current];
+  w->full.push(w->current);
+  w->current = -1;
+}
+
+void ParallelCacheSim::access(uint64_t addr, bool write) {
+  addr = CM::normalize(addr);
+  uint32_t slice = nslice > 1 ? hasher->hash(addr) : 0;
+  uint32_t idx = dispatch_cache->get_index(NULL, addr);
+  if(!dispatch_cache->sampled(idx)) { filtered++; return; }
+  Worker *w = owner(slice, idx);
+  Item item = {addr | (write ? 1 : 0), slice, idx};
+  if(reporter.enabled()) {
+    // events are recorded by the reporter of the calling thread, simulate here once the workers are idle
+    finish();
+    exec(w, item);
+    return;
+  }
+  if(w->current < 0) {
+    uint32_t i;
+    while(!w->free.pop(i)) std::this_thread::yield();
+    w->current = i;
+    w->sizes[i] = 0;
+  }
+  w->batches[w->current][w->sizes[w->current]++] = item;
+  if(w->sizes[w->current] == batch_size) push(w);
+}
+
+uint64_t ParallelCacheSim::replay(const TraceRecord *records, size_t n) {
+  uint64_t rv = 0;
+  for(size_t i=0; i<n; i++) {
+    if(records[i].op > TraceRecord::WRITE) continue;
+    access(records[i].addr, records[i].op == TraceRecord::WRITE);
+    rv++;
+  }
+  return rv;
+}
+
+void ParallelCacheSim::finish() {
+  for(auto &w : workers) push(w.get());
+  for(auto &w : workers)
+    while(w->processed.load(std::memory_order_acquire) != w->dispatched)
+      std::this_thread::yield();
+}
+
+ParallelCacheSim::Counters ParallelCacheSim::counters() const {
+  Counters rv;
+  for(auto &w : workers) rv += w->counters;
+  return rv;
+}
+
+uint64_t ParallelCacheSim::sample_estimate(SampledRatioStat *miss_rate) const {
+  if(dispatch_cache->sample <= 1) return 0;
+  miss_rate->add_population((uint64_t)nslice * nset);
+  uint64_t total = filtered;
+  for(uint32_t s=0; s<nslice; s++)
+    for(uint32_t idx=0; idx<nset; idx++)
+      if(dispatch_cache->sampled(idx)) {
+        uint64_t access, miss;
+        owner(s, idx)->caches[s]->get_cache()->sample_counts(idx, &access, &miss);
+        miss_rate->record(miss, access);
+        total += access;
+      }
+  return total;
+}
@@ -0,0 +1,87 @@
+#ifndef UTIL_PARALLEL_SIM_HPP_
+#define UTIL_PARALLEL_SIM_HPP_
+
+#include "cache/definitions.hpp"
+#include "util/ring.hpp"
+#include "util/trace.hpp"
+#include <thread>
+#include <atomic>
+#include <memory>
+
+class SampledRatioStat;
+
+// Parallel simulation of a single (write-back, non-coherent) cache level partitioned by sets.
+//   The (slice, set) pairs are split into contiguous blocks, one per worker thread. Every worker
+//   owns a single-level CoherentCache per slice but only touches the meta rows and replacement state
+//   of its block, so workers share nothing and run without locks. The caller dispatches accesses in
+//   batches through lock-free rings, which keeps the access order of every set; counters are merged
+//   on read. Replacement state is per set (random replacement draws per set), so the results do not
+//   depend on the number of workers. The reporter is per thread, so while the calling thread records
+//   events, accesses are simulated on the calling thread instead.
+
+class ParallelCacheSim
+{
+public:
+  struct Counters {
+    uint64_t access, miss, write, evict, writeback;
+    Counters() : access(0), miss(0), write(0), evict(0), writeback(0) {}
+    Counters &operator+=(const Counters &c);
+  };
+
+private:
+  struct Item {
+    uint64_t addr;    // normalized, bit 0 set for a write
+    uint32_t slice, idx;
+  };
+
+  class Slice;
+
+  struct Worker {
+    std::vector<Slice *> caches;              // one per slice, only the sets of this worker are used
+    std::vector<std::vector<Item> > batches;
+    std::vector<size_t> sizes;
+    SPSCRing<uint32_t> full, free;            // batch indices
+    int32_t current;                          // the batch being filled by the dispatcher, -1 if none
+    std::atomic<uint64_t> dispatched, processed;
+    Counters counters;
+    std::thread thread;
+    Worker(uint32_t nbatch) : full(nbatch), free(nbatch), current(-1), dispatched(0), processed(0) {}
+  };
+
+  uint32_t nslice, nset;
+  size_t batch_size;
+  CacheBase *dispatch_cache;                  // indexer and set sampling of the dispatcher
+  LLCHashBase *hasher;
+  std::vector<std::unique_ptr<Worker> > workers;
+  std::atomic<bool> stop;
+  uint64_t filtered;
+
+  Worker *owner(uint32_t slice, uint32_t idx) const {   // contiguous blocks of (slice, set) pairs per worker
+    return workers[((uint64_t)slice * nset + idx) * workers.size() / ((uint64_t)nslice * nset)].get();
+  }
+  void exec(Worker *w, const Item &it);
+  void work(Worker *w);
+  void push(Worker *w);
+
+public:
+  // nworker threads simulating nslice caches created by `cc' (at `level'), slices selected by `hc'
+  ParallelCacheSim(uint32_t nworker, uint32_t nslice, cache_creator_t cc, llc_hash_creator_t hc,
+                   uint32_t level = 2, uint32_t nbatch = 4, size_t batch_size = 1 << 12);
+  ~ParallelCacheSim();
+
+  void access(uint64_t addr, bool write);
+  // dispatch the reads and writes of a trace (all cores), return the number of dispatched records
+  uint64_t replay(const TraceRecord *records, size_t n);
+  // wait until all dispatched accesses are simulated
+  void finish();
+
+  // merged counters, call finish() first
+  Counters counters() const;
+  uint64_t get_filtered() const { return filtered; }   // accesses dropped by set sampling
+  // add the sampled sets to a miss rate estimate, return the number of accesses (sampled and filtered),
+  // nothing is added without sampling; call finish() first
+  uint64_t sample_estimate(SampledRatioStat *miss_rate) const;
+  uint32_t get_nworker() const { return workers.size(); }
+};
+
+#endif
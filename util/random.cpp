@@ -1,70 +1,128 @@
 #include "util/random.hpp"
-#include <boost/random/uniform_int_distribution.hpp>
-#include "datagen/include/random_generator.h"
-#include <map>
+#include <algorithm>
+#include <unordered_map>
 
-static boost::random::mt19937_64 hash_gen;
-static boost::random::uniform_int_distribution<uint64_t> ranGen64;
+static thread_local RandomGen thread_gen;
+
+RandomGen *default_random_gen() {
+  return &thread_gen;
+}
+
+void random_seed(uint64_t seed) {
+  thread_gen.seed(seed);
+}
 
 uint64_t hash(uint64_t seed) {
-  hash_gen.seed(seed);
-  return ranGen64(hash_gen);
+  RandomGen hash_gen(seed);
+  return hash_gen.next();
 }
 
-uint64_t get_random_uint64(uint64_t max) {
-  return random_uint_uniform(60, 0, max-1);
+uint64_t get_random_uint64(uint64_t max, RandomGen *rng) {
+  if(!rng) rng = default_random_gen();
+  return rng->uniform(max);
 }
 
 void get_random_set64(
                     std::unordered_set<uint64_t> &random_set, // the set containing the random numbers
                     uint32_t num,            // number of random number to be generated
-                    uint64_t max             // the maximam number to be generated
+                    uint64_t max,            // the maximam number to be generated
+                    RandomGen *rng           // the random number generator
                     )
 {
-  if(max <= num) {
-    for(uint32_t i=0; i<max; i++)
-      random_set.insert(random_set.begin(), i);
-  } else {
-    for(uint32_t i=0; random_set.size()<num; i++)
-      random_set.insert(random_set.begin(), get_random_uint64(max));
-  }
+  std::vector<uint64_t> random_vector;
+  get_random_vector(random_vector, num, max, rng);
+  random_set.insert(random_vector.begin(), random_vector.end());
 }
 
 void get_random_set32(
                     std::unordered_set<uint32_t> &random_set, // the set containing the random numbers
                     uint32_t num,            // number of random number to be generated
-                    uint32_t max             // the maximam number to be generated
+                    uint32_t max,            // the maximam number to be generated
+                    RandomGen *rng           // the random number generator
                     )
 {
-  if(max <= num) {
-    for(uint32_t i=0; i<max; i++)
-      random_set.insert(random_set.begin(), i);
-  } else {
-    for(uint32_t i=0; random_set.size()<num; i++)
-      random_set.insert(random_set.begin(), (uint32_t)get_random_uint64(max));
-  }
+  std::vector<uint64_t> random_vector;
+  get_random_vector(random_vector, num, max, rng);
+  random_set.insert(random_vector.begin(), random_vector.end());
 }
 
 void get_random_list(
                      std::list<uint64_t> &random_list, // the set containing the random numbers
                      uint32_t num,              // number of random number to be generated
-                     uint64_t max               // the maximam number to be generated
+                     uint64_t max,              // the maximam number to be generated
+                     RandomGen *rng             // the random number generator
                      )
 {
-  std::unordered_set<uint64_t> random_set;
-  get_random_set64(random_set, num, max);
-  random_list = std::list<uint64_t>(random_set.begin(), random_set.end());
+  std::vector<uint64_t> random_vector;
+  get_random_vector(random_vector, num, max, rng);
+  random_list = std::list<uint64_t>(random_vector.begin(), random_vector.end());
 }
 
-void shuffle_list(std::list<uint64_t> &random_list) {
-  std::map<uint64_t, uint64_t> buf;
-  while(!random_list.empty()) {
-    uint64_t rid;
-    do {
-      rid = get_random_uint64(1ull << 60);
-    } while(buf.count(rid));
-    buf[rid] = random_list.back();
-    random_list.pop_back();
+void shuffle_list(std::list<uint64_t> &random_list, RandomGen *rng) {
+  std::vector<uint64_t> buf(random_list.begin(), random_list.end());
+  shuffle_vector(buf, rng);
+  std::copy(buf.begin(), buf.end(), random_list.begin());
+}
+
+void shuffle_vector(std::vector<uint64_t> &random_vector, RandomGen *rng) {
+  if(!rng) rng = default_random_gen();
+  for(size_t i=random_vector.size(); i>1; i--)
+    std::swap(random_vector[i-1], random_vector[rng->uniform(i)]);
+}
+
+void get_random_vector(
+                       std::vector<uint64_t> &random_vector, // the vector containing the random numbers
+                       uint32_t num,              // number of random number to be generated
+                       uint64_t max,              // the maximam number to be generated
+                       RandomGen *rng             // the random number generator
+                       )
+{
+  if(!rng) rng = default_random_gen();
+  random_vector.clear();
+  if(max <= num) {
+    random_vector.resize(max);
+    for(uint64_t i=0; i<max; i++) random_vector[i] = i;
+    shuffle_vector(random_vector, rng);
+  } else if(max <= 4ull * num) {
+    // dense: partial Fisher-Yates on [0, max)
+    std::vector<uint64_t> buf(max);
+    for(uint64_t i=0; i<max; i++) buf[i] = i;
+    for(uint32_t i=0; i<num; i++)
+      std::swap(buf[i], buf[i + rng->uniform(max - i)]);
+    random_vector.assign(buf.begin(), buf.begin() + num);
+  } else {
+    // sparse: partial Fisher-Yates on a virtual [0, max), only the displaced positions are stored
+    std::unordered_map<uint64_t, uint64_t> moved;
+    moved.reserve(2 * num);
+    random_vector.resize(num);
+    for(uint32_t i=0; i<num; i++) {
+      uint64_t j = i + rng->uniform(max - i);
+      auto it_j = moved.find(j);
+      uint64_t vj = it_j == moved.end() ? j : it_j->second;
+      auto it_i = moved.find(i);
+      moved[j] = it_i == moved.end() ? i : it_i->second;
+      random_vector[i] = vj;
+    }
+  }
+}
+
+void split_random_list(
+                       std::list<uint64_t> &src,    // the list to be picked from
+                       std::list<uint64_t> &picked, // the picked elements
+                       uint32_t num,                // number of elements to be picked
+                       RandomGen *rng               // the random number generator
+                       )
+{
+  if(!rng) rng = default_random_gen();
+  uint64_t remain = src.size();
+  auto it = src.begin();
+  while(num > 0 && it != src.end()) {
+    if(rng->uniform(remain) < num) {
+      auto picked_it = it++;
+      picked.splice(picked.end(), src, picked_it);
+      num--;
+    } else
+      it++;
+    remain--;
   }
-  for(auto r : buf) random_list.push_back(r.second);
 }
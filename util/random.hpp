@@ -2,19 +2,83 @@
 #define CM_UTIL_RANDOM_HPP_
 
 #include <cstdint>
+#include <cstddef>
 #include <unordered_set>
 #include <list>
+#include <vector>
+
+// xoshiro256** pseudo random number generator
+//   http://prng.di.unimi.it/
+// each instance owns its state, so independent instances can be used by different threads
+class RandomGen
+{
+  uint64_t s[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+  typedef uint64_t result_type;
+
+  RandomGen(uint64_t seed = 0) { this->seed(seed); }
+
+  // expand a 64-bit seed into the 256-bit state using splitmix64
+  void seed(uint64_t seed) {
+    for(int i=0; i<4; i++) {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      s[i] = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t next() {
+    uint64_t rv = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return rv;
+  }
+
+  // unbiased random number in [0, max), 0 for an empty range (max == 0)
+  uint64_t uniform(uint64_t max) {
+    if(max == 0) return 0;
+    uint64_t threshold = (0 - max) % max;
+    uint64_t r;
+    do { r = next(); } while(r < threshold);
+    return r % max;
+  }
+
+  // make it usable by the standard algorithms
+  uint64_t operator()() { return next(); }
+  static constexpr uint64_t min() { return 0; }
+  static constexpr uint64_t max() { return UINT64_MAX; }
+};
+
+// the default generator of the calling thread, used when no generator is provided
+extern RandomGen *default_random_gen();
+extern void random_seed(uint64_t seed);
 
 // a 64-bit hash function using the 64-bit random number generator
 extern uint64_t hash(uint64_t);
 
-extern uint64_t get_random_uint64(uint64_t max);
+// random number in [0, max), 0 when max == 0
+extern uint64_t get_random_uint64(uint64_t max, RandomGen *rng = NULL);
+
+extern void get_random_set64(std::unordered_set<uint64_t> &random_set, uint32_t num, uint64_t max, RandomGen *rng = NULL);
+extern void get_random_set32(std::unordered_set<uint32_t> &random_set, uint32_t num, uint32_t max, RandomGen *rng = NULL);
+
+extern void get_random_list(std::list<uint64_t> &random_list, uint32_t num, uint64_t max, RandomGen *rng = NULL);
+
+extern void shuffle_list(std::list<uint64_t> &random_list, RandomGen *rng = NULL);
 
-extern void get_random_set64(std::unordered_set<uint64_t> &random_set, uint32_t num, uint64_t max);
-extern void get_random_set32(std::unordered_set<uint32_t> &random_set, uint32_t num, uint32_t max);
+// in-place Fisher-Yates shuffle, O(n)
+extern void shuffle_vector(std::vector<uint64_t> &random_vector, RandomGen *rng = NULL);
 
-extern void get_random_list(std::list<uint64_t> &random_list, uint32_t num, uint64_t max);
+// `num' distinct random numbers in [0, max) in random order, expected O(num)
+extern void get_random_vector(std::vector<uint64_t> &random_vector, uint32_t num, uint64_t max, RandomGen *rng = NULL);
 
-extern void shuffle_list(std::list<uint64_t> &random_list);
+// move `num' randomly selected elements from `src' to the end of `picked' (selection sampling, O(n))
+extern void split_random_list(std::list<uint64_t> &src, std::list<uint64_t> &picked, uint32_t num, RandomGen *rng = NULL);
 
 #endif
@@ -0,0 +1,18 @@
+#include "util/replay.hpp"
+
+uint64_t trace_replay(const TraceRecord *records, size_t n, const std::vector<CoherentCache *> &l1_caches) {
+  return replay_runs(records, n, l1_caches, [](L1CacheBase *cache, uint8_t op, size_t pos, const uint64_t *addrs, size_t m) {
+      if(op == TraceRecord::FLUSH)     cache->flush(addrs[0]);
+      else if(op == TraceRecord::READ) cache->read_batch(addrs, m);
+      else                             cache->write_batch(addrs, m);
+    });
+}
+
+uint64_t trace_replay(TraceStream &stream, const std::vector<CoherentCache *> &l1_caches) {
+  const TraceRecord *records;
+  size_t n;
+  uint64_t rv = 0;
+  while(stream.next(&records, &n))
+    rv += trace_replay(records, n, l1_caches);
+  return rv;
+}
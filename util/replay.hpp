@@ -0,0 +1,42 @@
+#ifndef UTIL_REPLAY_HPP_
+#define UTIL_REPLAY_HPP_
+
+#include "util/trace.hpp"
+#include "util/trace_import.hpp"
+#include "cache/cache.hpp"
+
+// Replay of traces on a cache hierarchy, kept apart from the trace formats (util/trace.hpp,
+// util/trace_import.hpp) so that trace tools do not link the cache model.
+
+// Group records (TraceRecord or a type with the same fields) into calls of the batched L1 interface:
+// `f(cache, op, pos, addrs, m)' for every run of up to `replay_batch' reads or writes of the same core
+// starting at record `pos', and for every flush (m = 1). Records of unknown cores or ops are skipped.
+// Return the number of records passed to `f'.
+const size_t replay_batch = 64;
+
+template<typename R, typename F>
+uint64_t replay_runs(const R *records, size_t n, const std::vector<CoherentCache *> &l1_caches, F f) {
+  uint64_t addrs[replay_batch];
+  uint64_t rv = 0;
+  size_t i = 0;
+  while(i < n) {
+    const R &r = records[i];
+    if(r.core >= l1_caches.size() || r.op > TraceRecord::FLUSH) { i++; continue; }
+    L1CacheBase *cache = static_cast<L1CacheBase *>(l1_caches[r.core]);
+    size_t pos = i, m = 0;
+    if(r.op == TraceRecord::FLUSH)
+      addrs[m++] = records[i++].addr;
+    else  // the following reads/writes of the same core
+      while(i < n && m < replay_batch && records[i].core == r.core && records[i].op == r.op)
+        addrs[m++] = records[i++].addr;
+    f(cache, r.op, pos, (const uint64_t *)addrs, m);
+    rv += m;
+  }
+  return rv;
+}
+
+// dispatch trace records to the L1 caches (l1_caches[core]), return the number of replayed records
+extern uint64_t trace_replay(const TraceRecord *records, size_t n, const std::vector<CoherentCache *> &l1_caches);
+extern uint64_t trace_replay(TraceStream &stream, const std::vector<CoherentCache *> &l1_caches);
+
+#endif
@@ -1,8 +1,14 @@
 #include "util/report.hpp"
+#include "util/event_trace.hpp"
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
+#include <algorithm>
+#include <tuple>
 #include <vector>
 #include <boost/format.hpp>
 #include <iostream>
@@ -55,7 +61,9 @@ class DBAccType : public CacheDB<AccRecord> {
   uint64_t m_writeback;
 public:
   bool detailed_to_addr;
-  DBAccType() : m_access(0), m_hit(0), m_evict(0), m_writeback(0), detailed_to_addr(false) {}
+  uint64_t cache_hash;  // the cache of a per-set tracer
+  int32_t set_idx;      // the set of a per-set tracer, -1 otherwise
+  DBAccType() : m_access(0), m_hit(0), m_evict(0), m_writeback(0), detailed_to_addr(false), cache_hash(0), set_idx(-1) {}
   virtual void access(uint64_t id, bool bhit, uint64_t *wt) {
     if(detailed_to_addr) get(id)->n_access++;
     m_access++;
@@ -188,34 +196,48 @@ public:
   }
 };
 
+// when an event trace is open, traced events are written to it as binary records instead of printed
 class DBAddrTraceType : public CacheDB<bool> {
 public:
+  EventTraceWriter *writer;
+  DBAddrTraceType() : writer(NULL) {}
   virtual ~DBAddrTraceType() {}
-  virtual void report(std::string msg, uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state) {
-    auto fmt = boost::format("0x%016x ") % addr;
-    std::cout << fmt.str();
-    fmt = boost::format(msg + " at level %1% core %2% cache %3% set %4% way %5% [%6%]") % level % core_id % cache_id % idx % way % state;
-    std::cout << fmt.str() << std::endl;
+  virtual void report(uint8_t event, uint64_t time, uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state) {
+    EventRecord r = {time, addr, idx, (uint16_t)way, (int16_t)core_id, (int16_t)cache_id, (uint8_t)level, event, (uint8_t)state, {0, 0, 0}};
+    if(writer) writer->write(r);
+    else       std::cout << event_to_string(r, false) << std::endl;
   }
 };
 
 class DBSetTraceType : public CacheDB<std::unordered_set<uint64_t> > {
 public:
+  EventTraceWriter *writer;
+  DBSetTraceType() : writer(NULL) {}
   virtual ~DBSetTraceType() {}
-  virtual void access(uint64_t id, uint64_t addr) {
+  virtual void access(uint64_t id, uint64_t addr, uint64_t time, uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) {
     auto blocks = get(id);
     if(!blocks->count(addr)) {
       blocks->insert(addr);
-      auto fmt = boost::format("0x%016x: ") % addr;
-      std::cout << "set " << id << " add " << fmt.str() << to_string(id) << std::endl;
+      if(writer) {
+        EventRecord r = {time, addr, idx, 0, (int16_t)core_id, (int16_t)cache_id, (uint8_t)level, EventRecord::SET_ADD, 0, {0, 0, 0}};
+        writer->write(r);
+      } else {
+        auto fmt = boost::format("0x%016x: ") % addr;
+        std::cout << "set " << id << " add " << fmt.str() << to_string(id) << std::endl;
+      }
     }
   }
 
-  virtual void evict(uint64_t id, uint64_t addr) {
+  virtual void evict(uint64_t id, uint64_t addr, uint64_t time, uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) {
     auto blocks = get(id);
     if(blocks->count(addr)) blocks->erase(addr);
-    auto fmt = boost::format("0x%016x: ") % addr;
-    std::cout << "set " << id << " evict " << fmt.str() << to_string(id) << std::endl;
+    if(writer) {
+      EventRecord r = {time, addr, idx, 0, (int16_t)core_id, (int16_t)cache_id, (uint8_t)level, EventRecord::SET_EVICT, 0, {0, 0, 0}};
+      writer->write(r);
+    } else {
+      auto fmt = boost::format("0x%016x: ") % addr;
+      std::cout << "set " << id << " evict " << fmt.str() << to_string(id) << std::endl;
+    }
   }
 
   virtual std::string to_string(uint64_t id) {
@@ -232,16 +254,156 @@ public:
   }
 };
 
+// per-way access counters of a cache stored in dense arrays
+class DBWayAccType {
+  std::vector<std::vector<AccRecord> > records;   // [set][way]
+
+  AccRecord *get(uint32_t idx, uint32_t way) {
+    if(idx >= records.size()) records.resize(idx+1);
+    if(way >= records[idx].size()) records[idx].resize(way+1);
+    return &(records[idx][way]);
+  }
+
+public:
+  void access(uint32_t idx, uint32_t way, bool bhit) {
+    AccRecord *r = get(idx, way);
+    r->n_access++;
+    if(bhit) r->n_hit++;
+  }
+  void evict(uint32_t idx, uint32_t way)     { get(idx, way)->n_evict++;     }
+  void writeback(uint32_t idx, uint32_t way) { get(idx, way)->n_writeback++; }
+  const AccRecord *at(uint32_t idx, uint32_t way) const {
+    static const AccRecord empty;
+    return (idx < records.size() && way < records[idx].size()) ? &(records[idx][way]) : &empty;
+  }
+  void clear() { records.clear(); }
+};
+
+// per-set access distribution of a cache stored in a dense array
+class DBSetDistType {
+  std::vector<AccRecord> records;   // [set], sized to the sets of the cache at registration
+
+  AccRecord *get(uint32_t idx) {
+    if(idx >= records.size()) records.resize(idx+1);
+    return &(records[idx]);
+  }
+
+public:
+  uint32_t level;
+  int32_t core_id, cache_id;
+  void access(uint32_t idx, bool bhit) {
+    AccRecord *r = get(idx);
+    r->n_access++;
+    if(bhit) r->n_hit++;
+  }
+  void evict(uint32_t idx)     { get(idx)->n_evict++;     }
+  void writeback(uint32_t idx) { get(idx)->n_writeback++; }
+  const std::vector<AccRecord> &dist() const { return records; }
+  void resize(uint32_t nset) { records.resize(nset); }
+  void clear() { records.assign(records.size(), AccRecord()); }
+};
+
+// access tracers resolved for a cache, so an event only indexes arrays
+struct CacheSlots {
+  bool resolved;
+  std::vector<DBAccType *> acc;      // cache level tracers (depth 0 to 2)
+  std::vector<DBAccType *> set_acc;  // set level tracers indexed by set, NULL if not traced
+  DBWayAccType *way_acc;             // way level tracers
+  DBSetDistType *set_dist;           // set distribution tracer
+  CacheSlots() : resolved(false), way_acc(NULL), set_dist(NULL) {}
+};
+
+// periodic dump of the access counters of a cache (or a group of caches)
+struct IntervalReporter {
+  uint64_t id;            // the access tracer being sampled
+  uint32_t level;
+  int32_t core_id;        // -1 when not specified by the tracer depth
+  int32_t cache_id;       // -1 when not specified by the tracer depth
+  uint64_t period;
+  uint64_t next;          // time of the next sample
+  uint64_t last[4];       // access, hit, evict and writeback at the last sample
+  bool owned;             // the access tracer is registered by this reporter
+  FILE *fp;
+  bool binary;
+};
+
+// a sample in binary report files
+struct IntervalRecord {
+  uint64_t time;
+  uint32_t level;
+  int32_t  core_id;
+  int32_t  cache_id;
+  uint32_t pad;
+  uint64_t n_access;
+  uint64_t n_hit;
+  uint64_t n_evict;
+  uint64_t n_writeback;
+};
+
 struct ReportDBs {
+  std::vector<std::vector<std::vector<CacheSlots> > > slots; // [level][core_id+1][cache_id]
+  std::unordered_map<uint64_t, DBWayAccType> way_dbs;     // record access numbers of each way
+  std::unordered_map<uint64_t, DBSetDistType> set_dist_dbs; // record the access distribution over sets
   std::unordered_map<uint64_t, DBAccType>   acc_dbs;     // record various access numbers
   std::unordered_map<uint64_t, DBAddrType>  addr_dbs;    // record the set/way pairs of an addr in a cache
   std::unordered_map<uint64_t, DBStateType> state_dbs;   // record the coherent status of something
   DBAddrTraceType                           addr_traces; // trace a group of specific address of interests
   DBSetTraceType                            set_traces;  // trace a group of specific sets of interests
+  EventTraceWriter                          event_trace; // binary output of the address/set traces
+  uint64_t                                  event_seq;   // event timestamp when wall time is not set
+  std::list<IntervalReporter>               samplers;    // periodic reporters
+  std::unordered_map<std::string, FILE *>   sample_files;// output files of periodic reporters
+  uint64_t                                  sample_clock;// access count, the sample time when wall time is not set
+  uint64_t                                  next_sample; // the earliest sample time of all periodic reporters
+  std::vector<AccessMonitor *>              monitors;    // attached access monitors
+  uint32_t                                  tracers[5][5]; // number of registered tracers [type][depth]
+  ReportDBs() : event_seq(0), sample_clock(0), next_sample(0) { memset(tracers, 0, sizeof(tracers)); }
 };
 
-Reporter_t::Reporter_t() : dbs(new ReportDBs), db_depth(4, false), db_type(4, false) {}
-Reporter_t::~Reporter_t() { delete dbs; }
+Reporter_t::Reporter_t() : dbs(new ReportDBs), wall_time(NULL), db_enable(0) {}
+Reporter_t::~Reporter_t() { remove_reporters(); delete dbs; }
+
+uint64_t Reporter_t::event_time() {
+  return wall_time ? *wall_time : dbs->event_seq++;
+}
+
+bool Reporter_t::open_event_trace(const std::string &fn, const std::string &compress) {
+  close_event_trace();
+  if(!dbs->event_trace.open(fn, compress)) return false;
+  dbs->addr_traces.writer = &(dbs->event_trace);
+  dbs->set_traces.writer = &(dbs->event_trace);
+  dbs->event_seq = 0;
+  return true;
+}
+
+bool Reporter_t::close_event_trace() {
+  dbs->addr_traces.writer = NULL;
+  dbs->set_traces.writer = NULL;
+  return dbs->event_trace.close();
+}
+
+CacheSlots *Reporter_t::resolve_slots(uint32_t level, int32_t core_id, int32_t cache_id) {
+  auto &table = dbs->slots;
+  if(level >= table.size()) table.resize(level+1);
+  if(core_id+1 >= (int32_t)table[level].size()) table[level].resize(core_id+2);
+  if(cache_id >= (int32_t)table[level][core_id+1].size()) table[level][core_id+1].resize(cache_id+1);
+  CacheSlots *s = &(table[level][core_id+1][cache_id]);
+  if(s->resolved) return s;
+
+  uint64_t ids[3] = {hash(level), hash(level, core_id), hash(level, core_id, cache_id)};
+  for(uint32_t d=0; d<3; d++)
+    if(db_depth(d) && dbs->acc_dbs.count(ids[d])) s->acc.push_back(&(dbs->acc_dbs[ids[d]]));
+  if(db_depth(3))
+    for(auto &db : dbs->acc_dbs)
+      if(db.second.set_idx >= 0 && db.second.cache_hash == ids[2]) {
+        if(db.second.set_idx >= (int32_t)s->set_acc.size()) s->set_acc.resize(db.second.set_idx+1, NULL);
+        s->set_acc[db.second.set_idx] = &(db.second);
+      }
+  if(db_depth(4) && dbs->way_dbs.count(ids[2])) s->way_acc = &(dbs->way_dbs[ids[2]]);
+  if(db_type(4) && dbs->set_dist_dbs.count(ids[2])) s->set_dist = &(dbs->set_dist_dbs[ids[2]]);
+  s->resolved = true;
+  return s;
+}
 
 
 // register recorders
@@ -252,39 +414,146 @@ void Reporter_t::register_tracer_generic(uint32_t tracer_type, uint32_t tracer_d
   case 1: id = hash(level, core_id); break;
   case 2: id = hash(level, core_id, cache_id); break;
   case 3: id = hash(level, core_id, cache_id, idx); break;
+  case 4: id = hash(level, core_id, cache_id); break;
   default: id = 0; // should not run here
 }
   switch(tracer_type) {
   case 0: // access trace
-  assert(!dbs->acc_dbs.count(id));
-    dbs->acc_dbs[id].detailed_to_addr = extra;
-    db_depth[tracer_depth] = true;
-  db_type[0] = true;
+    if(tracer_depth == 4) {
+      assert(!dbs->way_dbs.count(id));
+      dbs->way_dbs[id];
+    } else {
+      assert(!dbs->acc_dbs.count(id));
+      dbs->acc_dbs[id].detailed_to_addr = extra;
+      if(tracer_depth == 3) {
+        dbs->acc_dbs[id].cache_hash = hash(level, core_id, cache_id);
+        dbs->acc_dbs[id].set_idx = idx;
+      }
+    }
+    dbs->slots.clear();
+    db_enable |= db_depth_bit(tracer_depth);
+  db_enable |= db_type_bit(0);
     break;
   case 1: // address trace
   assert(!dbs->addr_dbs.count(id));
   dbs->addr_dbs[id];
-    db_depth[tracer_depth] = true;
-  db_type[1] = true;
+    db_enable |= db_depth_bit(tracer_depth);
+  db_enable |= db_type_bit(1);
     break;
   case 2: // state trace
   assert(!dbs->state_dbs.count(id));
   dbs->state_dbs[id];
-    db_depth[tracer_depth] = true;
-  db_type[2] = true;
+    db_enable |= db_depth_bit(tracer_depth);
+  db_enable |= db_type_bit(2);
     break;
   case 3: // address/set monitor
     if(tracer_depth == 3) {
+      if(dbs->set_traces.hit(id)) return;
       dbs->set_traces.set(id, std::unordered_set<uint64_t>());
-      db_depth[tracer_depth] = true;
+      db_enable |= db_depth_bit(tracer_depth);
     } else {
+      if(dbs->addr_traces.hit(addr)) return;
       dbs->addr_traces.set(addr, true);
     }
-    db_type[3] = true;
+    db_enable |= db_type_bit(3);
+    break;
+  case 4: // set distribution
+    assert(!dbs->set_dist_dbs.count(id));
+    dbs->set_dist_dbs[id].level = level;
+    dbs->set_dist_dbs[id].core_id = core_id;
+    dbs->set_dist_dbs[id].cache_id = cache_id;
+    dbs->set_dist_dbs[id].resize(idx); // the number of sets
+    dbs->slots.clear();
+    db_enable |= db_type_bit(4);
     break;
   default:
     return; // should not run to here
   }
+  dbs->tracers[tracer_type][tracer_depth]++;
+}
+
+// add a periodic reporter of the access counters
+bool Reporter_t::add_reporter_generic(uint32_t tracer_depth, uint32_t level, int32_t core_id, int32_t cache_id, const std::string &fn, uint64_t period) {
+  assert(tracer_depth <= 2 && period > 0);
+  IntervalReporter r;
+  r.binary = fn.size() > 4 && fn.compare(fn.size()-4, 4, ".bin") == 0;
+  if(!dbs->sample_files.count(fn)) {
+    FILE *fp = fopen(fn.c_str(), r.binary ? "ab" : "a");
+    if(!fp) {
+      std::cerr << boost::format("Fail to open report file `%1%'. ") % fn << std::endl;
+      return false;
+    }
+    if(!r.binary && ftell(fp) == 0) fprintf(fp, "time,level,core,cache,access,hit,miss,evict,writeback\n");
+    dbs->sample_files[fn] = fp;
+  }
+  r.fp = dbs->sample_files[fn];
+
+  r.id = tracer_depth == 0 ? hash(level) : tracer_depth == 1 ? hash(level, core_id) : hash(level, core_id, cache_id);
+  r.level = level;
+  r.core_id = tracer_depth >= 1 ? core_id : -1;
+  r.cache_id = tracer_depth >= 2 ? cache_id : -1;
+  r.owned = !dbs->acc_dbs.count(r.id);
+  if(r.owned) register_tracer_generic(0, tracer_depth, level, core_id, cache_id, 0, 0, false);
+  const DBAccType &db = dbs->acc_dbs[r.id];
+  r.last[0] = db.get_access(); r.last[1] = db.get_hit(); r.last[2] = db.get_evict(); r.last[3] = db.get_writeback();
+
+  uint64_t now = wall_time ? *wall_time : dbs->sample_clock;
+  r.period = period;
+  r.next = now + period;
+  if(dbs->samplers.empty() || r.next < dbs->next_sample) dbs->next_sample = r.next;
+  dbs->samplers.push_back(r);
+  db_enable |= db_type_bit(5);
+  return true;
+}
+
+void Reporter_t::sample(uint64_t now, bool force) {
+  uint64_t next = UINT64_MAX;
+  for(auto &r : dbs->samplers) {
+    if((force || now >= r.next) && dbs->acc_dbs.count(r.id)) {
+      const DBAccType &db = dbs->acc_dbs[r.id];
+      uint64_t cnt[4] = {db.get_access(), db.get_hit(), db.get_evict(), db.get_writeback()};
+      if(r.binary) {
+        IntervalRecord rec = {now, r.level, r.core_id, r.cache_id, 0, cnt[0]-r.last[0], cnt[1]-r.last[1], cnt[2]-r.last[2], cnt[3]-r.last[3]};
+        fwrite(&rec, sizeof(rec), 1, r.fp);
+      } else {
+        fprintf(r.fp, "%" PRIu64 ",%u,%d,%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", now, r.level, r.core_id, r.cache_id,
+                cnt[0]-r.last[0], cnt[1]-r.last[1], (cnt[0]-cnt[1])-(r.last[0]-r.last[1]), cnt[2]-r.last[2], cnt[3]-r.last[3]);
+      }
+      for(int i=0; i<4; i++) r.last[i] = cnt[i];
+    }
+    if(now >= r.next) r.next += ((now - r.next) / r.period + 1) * r.period; // skip empty intervals
+    if(r.next < next) next = r.next;
+  }
+  dbs->next_sample = next;
+}
+
+void Reporter_t::flush_reporters() {
+  if(dbs->samplers.empty()) return;
+  sample(wall_time ? *wall_time : dbs->sample_clock, true);
+  for(auto &f : dbs->sample_files) fflush(f.second);
+}
+
+void Reporter_t::remove_reporters() {
+  flush_reporters();
+  for(auto &r : dbs->samplers)
+    if(r.owned && dbs->acc_dbs.count(r.id)) {
+      remove_tracer_generic(0, r.core_id < 0 ? 0 : r.cache_id < 0 ? 1 : 2, r.level, r.core_id, r.cache_id, 0, 0);
+    }
+  for(auto &f : dbs->sample_files) fclose(f.second);
+  dbs->samplers.clear();
+  dbs->sample_files.clear();
+  update_enable();
+}
+
+void Reporter_t::attach_monitor(AccessMonitor *m) {
+  dbs->monitors.push_back(m);
+  db_enable |= db_type_bit(6);
+}
+
+void Reporter_t::detach_monitor(AccessMonitor *m) {
+  auto &ms = dbs->monitors;
+  ms.erase(std::remove(ms.begin(), ms.end(), m), ms.end());
+  update_enable();
 }
 
 // remove a certain recorder
@@ -295,12 +564,19 @@ void Reporter_t::remove_tracer_generic(uint32_t tracer_type, uint32_t tracer_dep
   case 1: id = hash(level, core_id); break;
   case 2: id = hash(level, core_id, cache_id); break;
   case 3: id = hash(level, core_id, cache_id, idx); break;
+  case 4: id = hash(level, core_id, cache_id); break;
   default: id = 0; // should not run here
   }
   switch(tracer_type) {
   case 0: // access trace
-    assert(dbs->acc_dbs.count(id));
-    dbs->acc_dbs.erase(id);
+    if(tracer_depth == 4) {
+      assert(dbs->way_dbs.count(id));
+      dbs->way_dbs.erase(id);
+    } else {
+      assert(dbs->acc_dbs.count(id));
+      dbs->acc_dbs.erase(id);
+    }
+    dbs->slots.clear();
     break;
   case 1: // address trace
     assert(dbs->addr_dbs.count(id));
@@ -312,14 +588,42 @@ void Reporter_t::remove_tracer_generic(uint32_t tracer_type, uint32_t tracer_dep
     break;
   case 3: // address/set monitor
     if(tracer_depth == 3) {
+      if(!dbs->set_traces.hit(id)) return;
       dbs->set_traces.clear(id);
     } else {
+      if(!dbs->addr_traces.hit(addr)) return;
       dbs->addr_traces.clear(addr);
     }
     break;
+  case 4: // set distribution
+    assert(dbs->set_dist_dbs.count(id));
+    dbs->set_dist_dbs.erase(id);
+    dbs->slots.clear();
+    break;
   default:
     return; // should not run to here
   }
+  dbs->tracers[tracer_type][tracer_depth]--;
+  update_enable();
+}
+
+// rebuild the enable word from the registered tracers, reporters and monitors
+void Reporter_t::update_enable() {
+  uint32_t e = 0;
+  for(uint32_t t=0; t<5; t++)
+    for(uint32_t d=0; d<5; d++)
+      if(dbs->tracers[t][d]) {
+        e |= db_type_bit(t);
+        if(t < 3 || (t == 3 && d == 3)) e |= db_depth_bit(d);
+      }
+  if(!dbs->samplers.empty()) e |= db_type_bit(5);
+  if(!dbs->monitors.empty()) e |= db_type_bit(6);
+  db_enable = e;
+}
+
+void Reporter_t::clear_tracers(uint32_t t) {
+  for(uint32_t d=0; d<5; d++) dbs->tracers[t][d] = 0;
+  update_enable();
 }
 
 // reset a certain recorder
@@ -330,12 +634,18 @@ void Reporter_t::reset_tracer_generic(uint32_t tracer_type, uint32_t tracer_dept
   case 1: id = hash(level, core_id); break;
   case 2: id = hash(level, core_id, cache_id); break;
   case 3: id = hash(level, core_id, cache_id, idx); break;
+  case 4: id = hash(level, core_id, cache_id); break;
   default: id = 0; // should not run here
   }
   switch(tracer_type) {
   case 0: // access trace
-    assert(dbs->acc_dbs.count(id));
-    dbs->acc_dbs[id].clear();
+    if(tracer_depth == 4) {
+      assert(dbs->way_dbs.count(id));
+      dbs->way_dbs[id].clear();
+    } else {
+      assert(dbs->acc_dbs.count(id));
+      dbs->acc_dbs[id].clear();
+    }
     break;
   case 1: // address trace
     assert(dbs->addr_dbs.count(id));
@@ -345,105 +655,122 @@ void Reporter_t::reset_tracer_generic(uint32_t tracer_type, uint32_t tracer_dept
     assert(dbs->state_dbs.count(id));
     dbs->state_dbs[id].clear();
     break;
+  case 4: // set distribution
+    assert(dbs->set_dist_dbs.count(id));
+    dbs->set_dist_dbs[id].clear();
+    break;
   default:
     return; // should not run to here
   }
 }
 
 // clear recorders
-void Reporter_t::clear_acc_dbs()     { dbs->acc_dbs.clear();   db_type[0] = false; }
-void Reporter_t::clear_addr_dbs()    { dbs->addr_dbs.clear();  db_type[1] = false; }
-void Reporter_t::clear_state_dbs()   { dbs->state_dbs.clear(); db_type[2] = false; }
-void Reporter_t::clear_addr_traces() { dbs->addr_traces.clear();                   }
-void Reporter_t::clear_set_traces()  { dbs->set_traces.clear();                    }
+void Reporter_t::clear_acc_dbs()     { dbs->acc_dbs.clear(); dbs->way_dbs.clear(); dbs->slots.clear(); clear_tracers(0); }
+void Reporter_t::clear_addr_dbs()    { dbs->addr_dbs.clear();  clear_tracers(1); }
+void Reporter_t::clear_state_dbs()   { dbs->state_dbs.clear(); clear_tracers(2); }
+void Reporter_t::clear_addr_traces() { dbs->addr_traces.clear(); dbs->tracers[3][0] = 0; update_enable(); }
+void Reporter_t::clear_set_traces()  { dbs->set_traces.clear();  dbs->tracers[3][3] = 0; update_enable(); }
+void Reporter_t::clear_set_dist_dbs() { dbs->set_dist_dbs.clear(); dbs->slots.clear(); clear_tracers(4); }
 void Reporter_t::clear() {
+  remove_reporters();
+  dbs->monitors.clear();
   clear_acc_dbs();
   clear_addr_dbs();
   clear_state_dbs();
   clear_addr_traces();
   clear_set_traces();
-  db_depth = std::vector<bool>(4, false);
-  db_type = std::vector<bool>(4, false);
+  clear_set_dist_dbs();
+  db_enable = 0;
 }
 
   // event recorders
-void Reporter_t::cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state, bool hit) {
+void Reporter_t::cache_access_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state, bool hit) {
   uint64_t record = addr_hash(addr);
-  if(db_depth[0]) {
+  if(db_type(5)) {
+    uint64_t now = wall_time ? *wall_time : dbs->sample_clock++;
+    if(now >= dbs->next_sample) sample(now, false);
+  }
+  if(db_type(6))
+    for(auto m : dbs->monitors) m->access(level, core_id, cache_id, addr, idx, way, hit);
+  if(db_type(0) || db_type(4)) {
+    CacheSlots *slots = resolve_slots(level, core_id, cache_id);
+    for(auto db : slots->acc) db->access(record, hit, wall_time);
+    if(idx < slots->set_acc.size() && slots->set_acc[idx]) slots->set_acc[idx]->access(record, hit, wall_time);
+    if(slots->way_acc) slots->way_acc->access(idx, way, hit);
+    if(slots->set_dist) slots->set_dist->access(idx, hit);
+  }
+  if(db_depth(0)) {
     uint64_t id = hash(level);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].access(record, hit, wall_time);
-    if(db_type[1] && dbs->addr_dbs.count(id))  dbs->addr_dbs[id].access(record, idx, way);
-    if(db_type[2] && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, state);
+    if(db_type(1) && dbs->addr_dbs.count(id))  dbs->addr_dbs[id].access(record, idx, way);
+    if(db_type(2) && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, state);
   }
-  if(db_depth[1]) {
+  if(db_depth(1)) {
     uint64_t id = hash(level, core_id);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].access(record, hit, wall_time);
-    if(db_type[1] && dbs->addr_dbs.count(id))  dbs->addr_dbs[id].access(record, idx, way);
-    if(db_type[2] && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, state);
+    if(db_type(1) && dbs->addr_dbs.count(id))  dbs->addr_dbs[id].access(record, idx, way);
+    if(db_type(2) && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, state);
   }
-  if(db_depth[2]) {
+  if(db_depth(2)) {
     uint64_t id = hash(level, core_id, cache_id);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].access(record, hit, wall_time);
-    if(db_type[1] && dbs->addr_dbs.count(id))  dbs->addr_dbs[id].access(record, idx, way);
-    if(db_type[2] && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, state);
+    if(db_type(1) && dbs->addr_dbs.count(id))  dbs->addr_dbs[id].access(record, idx, way);
+    if(db_type(2) && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, state);
   }
-  if(db_depth[3]) {
+  if(db_depth(3)) {
     uint64_t id = hash(level, core_id, cache_id, idx);
-    if(db_type[0] && dbs->acc_dbs.count(id))  dbs->acc_dbs[id].access(record, hit, wall_time);
-    if(db_type[3] && dbs->set_traces.hit(id)) dbs->set_traces.access(id, addr);
+    if(db_type(3) && dbs->set_traces.hit(id)) dbs->set_traces.access(id, addr, event_time(), level, core_id, cache_id, idx);
   }
-  if(db_type[3] && dbs->addr_traces.hit(addr)) {
-    dbs->addr_traces.report("is accessed", level, core_id, cache_id, addr, idx, way, state);
+  if(db_type(3) && dbs->addr_traces.hit(addr)) {
+    dbs->addr_traces.report(EventRecord::ACCESS, event_time(), level, core_id, cache_id, addr, idx, way, state);
   }
 }
 
-void Reporter_t::cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
+void Reporter_t::cache_evict_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
   uint64_t record = addr_hash(addr);
-  if(db_depth[0]) {
+  if(db_type(6))
+    for(auto m : dbs->monitors) m->evict(level, core_id, cache_id, addr, idx, way);
+  if(db_type(0) || db_type(4)) {
+    CacheSlots *slots = resolve_slots(level, core_id, cache_id);
+    for(auto db : slots->acc) db->evict(record);
+    if(idx < slots->set_acc.size() && slots->set_acc[idx]) slots->set_acc[idx]->evict(record);
+    if(slots->way_acc) slots->way_acc->evict(idx, way);
+    if(slots->set_dist) slots->set_dist->evict(idx);
+  }
+  if(db_depth(0)) {
     uint64_t id = hash(level);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].evict(record);
-    if(db_type[2] && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, 0);
+    if(db_type(2) && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, 0);
   }
-  if(db_depth[1]) {
+  if(db_depth(1)) {
     uint64_t id = hash(level, core_id);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].evict(record);
-    if(db_type[2] && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, 0);
+    if(db_type(2) && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, 0);
   }
-  if(db_depth[2]) {
+  if(db_depth(2)) {
     uint64_t id = hash(level, core_id, cache_id);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].evict(record);
-    if(db_type[2] && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, 0);
+    if(db_type(2) && dbs->state_dbs.count(id)) dbs->state_dbs[id].set_state(record, 0);
   }
-  if(db_depth[3]) {
+  if(db_depth(3)) {
     uint64_t id = hash(level, core_id, cache_id, idx);
-    if(db_type[0] && dbs->acc_dbs.count(id)) dbs->acc_dbs[id].evict(record);
-    if(db_type[3] && dbs->set_traces.hit(id)) dbs->set_traces.evict(id, addr);
+    if(db_type(3) && dbs->set_traces.hit(id)) dbs->set_traces.evict(id, addr, event_time(), level, core_id, cache_id, idx);
   }
-  if(db_type[3] && dbs->addr_traces.hit(addr)) {
-    dbs->addr_traces.report("is evicted", level, core_id, cache_id, addr, idx, way, 0);
+  if(db_type(3) && dbs->addr_traces.hit(addr)) {
+    dbs->addr_traces.report(EventRecord::EVICT, event_time(), level, core_id, cache_id, addr, idx, way, 0);
   }
 }
 
-void Reporter_t::cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
+void Reporter_t::cache_writeback_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
   uint64_t record = addr_hash(addr);
-  if(db_depth[0]) {
-    uint64_t id = hash(level);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].writeback(record);
-  }
-  if(db_depth[1]) {
-    uint64_t id = hash(level, core_id);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].writeback(record);
-  }
-  if(db_depth[2]) {
-    uint64_t id = hash(level, core_id, cache_id);
-    if(db_type[0] && dbs->acc_dbs.count(id))   dbs->acc_dbs[id].writeback(record);
-  }
-  if(db_depth[3]) {
-    uint64_t id = hash(level, core_id, cache_id, idx);
-    if(db_type[0] && dbs->acc_dbs.count(id)) dbs->acc_dbs[id].writeback(record);
+  if(db_type(0) || db_type(4)) {
+    CacheSlots *slots = resolve_slots(level, core_id, cache_id);
+    for(auto db : slots->acc) db->writeback(record);
+    if(idx < slots->set_acc.size() && slots->set_acc[idx]) slots->set_acc[idx]->writeback(record);
+    if(slots->way_acc) slots->way_acc->writeback(idx, way);
+    if(slots->set_dist) slots->set_dist->writeback(idx);
   }
 }
 
+void Reporter_t::cache_request_generic(int32_t core_id, uint32_t op, uint64_t addr) {
+  if(db_type(6))
+    for(auto m : dbs->monitors) m->request(core_id, op, addr);
+}
+
 // event checkers
 bool Reporter_t::check_hit_generic(uint64_t id, uint64_t addr) const {
   if(dbs->state_dbs.count(id)) {
@@ -523,3 +850,80 @@ uint64_t Reporter_t::check_cache_writeback_generic(uint64_t id) const {
 uint64_t Reporter_t::check_addr_writeback_generic(uint64_t id, uint64_t addr) const {
   return dbs->acc_dbs.count(id) ? dbs->acc_dbs.at(id).get_writeback(addr_hash(addr)) : 0;
 }
+
+const AccRecord *Reporter_t::check_way_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
+  static const AccRecord empty;
+  uint64_t id = hash(level, core_id, cache_id);
+  return dbs->way_dbs.count(id) ? dbs->way_dbs.at(id).at(idx, way) : &empty;
+}
+
+uint64_t Reporter_t::check_cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
+  return check_way_generic(level, core_id, cache_id, idx, way)->n_access;
+}
+
+uint64_t Reporter_t::check_cache_hit(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
+  return check_way_generic(level, core_id, cache_id, idx, way)->n_hit;
+}
+
+uint64_t Reporter_t::check_cache_miss(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
+  const AccRecord *r = check_way_generic(level, core_id, cache_id, idx, way);
+  return r->n_access - r->n_hit;
+}
+
+uint64_t Reporter_t::check_cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
+  return check_way_generic(level, core_id, cache_id, idx, way)->n_evict;
+}
+
+uint64_t Reporter_t::check_cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
+  return check_way_generic(level, core_id, cache_id, idx, way)->n_writeback;
+}
+
+// set distribution
+uint64_t Reporter_t::check_set_dist(uint32_t level, int32_t core_id, int32_t cache_id, std::vector<uint64_t> *access, std::vector<uint64_t> *miss, std::vector<uint64_t> *evict) const {
+  uint64_t id = hash(level, core_id, cache_id);
+  if(!dbs->set_dist_dbs.count(id)) return 0;
+  const std::vector<AccRecord> &dist = dbs->set_dist_dbs.at(id).dist();
+  if(access) access->clear();
+  if(miss)   miss->clear();
+  if(evict)  evict->clear();
+  for(auto &r : dist) {
+    if(access) access->push_back(r.n_access);
+    if(miss)   miss->push_back(r.n_access - r.n_hit);
+    if(evict)  evict->push_back(r.n_evict);
+  }
+  return dist.size();
+}
+
+// binary heatmap: per cache a header (level, core_id, cache_id, nset as 32-bit integers) followed by
+// nset records of 64-bit access, hit, evict and writeback counters
+bool Reporter_t::export_set_dist(const std::string &fn) const {
+  bool binary = fn.size() > 4 && fn.compare(fn.size()-4, 4, ".bin") == 0;
+  FILE *fp = fopen(fn.c_str(), binary ? "wb" : "w");
+  if(!fp) return false;
+  if(!binary) fprintf(fp, "level,core,cache,set,access,hit,miss,evict,writeback\n");
+
+  std::vector<const DBSetDistType *> dbv;    // export in a stable order
+  for(auto &db : dbs->set_dist_dbs) dbv.push_back(&(db.second));
+  std::sort(dbv.begin(), dbv.end(), [](const DBSetDistType *a, const DBSetDistType *b) {
+      return std::make_tuple(a->level, a->core_id, a->cache_id) < std::make_tuple(b->level, b->core_id, b->cache_id);
+    });
+  for(auto db : dbv) {
+    uint32_t level = db->level;
+    int32_t core_id = db->core_id, cache_id = db->cache_id;
+    const std::vector<AccRecord> &dist = db->dist();
+    if(binary) {
+      int32_t header[4] = {(int32_t)level, core_id, cache_id, (int32_t)dist.size()};
+      fwrite(header, sizeof(header), 1, fp);
+      for(auto &r : dist) {
+        uint64_t cnt[4] = {r.n_access, r.n_hit, r.n_evict, r.n_writeback};
+        fwrite(cnt, sizeof(cnt), 1, fp);
+      }
+    } else {
+      for(uint32_t i=0; i<dist.size(); i++)
+        fprintf(fp, "%u,%d,%d,%u,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", level, core_id, cache_id, i,
+                dist[i].n_access, dist[i].n_hit, dist[i].n_access - dist[i].n_hit, dist[i].n_evict, dist[i].n_writeback);
+    }
+  }
+  fclose(fp);
+  return true;
+}
@@ -7,6 +7,38 @@
 #include <functional>
 #include <string>
 class ReportDBs;
+struct CacheSlots;
+class AccRecord;
+
+// a generic observer of cache events, attached by Reporter_t::attach_monitor()
+class AccessMonitor
+{
+public:
+  enum { REQ_READ = 0, REQ_WRITE = 1, REQ_FLUSH = 2 };
+  // a read, write or flush issued by a core to its L1 cache
+  virtual void request(int32_t core_id, uint32_t op, uint64_t addr) {}
+  virtual void access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit) = 0;
+  virtual void evict(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {}
+  virtual ~AccessMonitor() {}
+
+protected:
+  // per-cache state of monitors tracking selected caches, kept in a map by cache key
+  static uint64_t cache_key(uint32_t level, int32_t core_id, int32_t cache_id) {
+    return ((uint64_t)level << 48) | ((uint64_t)(uint16_t)core_id << 32) | (uint32_t)cache_id;
+  }
+  template<typename M>
+  static auto find_cache(M &table, uint32_t level, int32_t core_id, int32_t cache_id) -> decltype(&(table.begin()->second)) {
+    auto it = table.find(cache_key(level, core_id, cache_id));
+    return it == table.end() ? NULL : &(it->second);
+  }
+};
+
+// Build with CM_REPORTER_DISABLE to compile out all event recording.
+#ifdef CM_REPORTER_DISABLE
+const bool reporter_enable = false;
+#else
+const bool reporter_enable = true;
+#endif
 
 class Reporter_t
 {
@@ -53,7 +85,7 @@ class Reporter_t
   }
 
   void register_tracer_generic(uint32_t tracer_type, uint32_t tracer_depth, uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint64_t addr, bool extra);
-  void add_reporter_generic(uint32_t tracer_depth, uint32_t level, int32_t core_id, int32_t cache_id, const std::string &fn, uint64_t period);
+  bool add_reporter_generic(uint32_t tracer_depth, uint32_t level, int32_t core_id, int32_t cache_id, const std::string &fn, uint64_t period);
   void remove_tracer_generic(uint32_t tracer_type, uint32_t tracer_depth, uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint64_t addr);
   void reset_tracer_generic(uint32_t tracer_type, uint32_t tracer_depth, uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint64_t addr);
   bool check_hit_generic(uint64_t id, uint64_t addr) const;
@@ -69,8 +101,26 @@ class Reporter_t
   uint64_t check_cache_writeback_generic(uint64_t id) const;
   uint64_t check_addr_writeback_generic(uint64_t id, uint64_t addr) const;
 
-  std::vector<bool> db_depth;
-  std::vector<bool> db_type;
+  // all enable flags in a single word: tracer depths at [4:0] and tracer types at [15:8]
+  // (type 5 marks periodic reporters and type 6 access monitors)
+  // events return immediately when no tracer is registered
+  uint32_t db_enable;
+  static uint32_t db_depth_bit(uint32_t d) { return 1u << d;     }
+  static uint32_t db_type_bit(uint32_t t)  { return 0x100u << t; }
+  bool db_depth(uint32_t d) const          { return db_enable & db_depth_bit(d); }
+  bool db_type(uint32_t t) const           { return db_enable & db_type_bit(t);  }
+  void update_enable();
+  void clear_tracers(uint32_t t);
+
+  uint64_t event_time();
+  void sample(uint64_t now, bool force);
+  CacheSlots *resolve_slots(uint32_t level, int32_t core_id, int32_t cache_id);
+  const AccRecord *check_way_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const;
+
+  void cache_access_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state, bool hit);
+  void cache_evict_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way);
+  void cache_writeback_generic(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way);
+  void cache_request_generic(int32_t core_id, uint32_t op, uint64_t addr);
 
 public:
   Reporter_t();
@@ -78,6 +128,13 @@ public:
 
   void set_wall_time(uint64_t *t) { wall_time = t; }
 
+  // whether any tracer, reporter or monitor is registered (events are recorded)
+  bool enabled() const { return reporter_enable && db_enable; }
+
+  // write the address/set trace events to a binary file (see util/event_trace.hpp) instead of stdout
+  bool open_event_trace(const std::string &fn, const std::string &compress = "");
+  bool close_event_trace();   // false when the trace could not be written completely
+
   // register recorders
   inline void register_cache_access_tracer(uint32_t level, bool detailed_to_addr = false) {
     register_tracer_generic(0, 0, level, 0, 0, 0, 0, detailed_to_addr);
@@ -91,8 +148,12 @@ public:
   inline void register_set_access_tracer(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, bool detailed_to_addr = false) {
     register_tracer_generic(0, 3, level, core_id, cache_id, idx, 0, detailed_to_addr);
   }
-  inline void register_set_dist_tracer(uint32_t level, int32_t core_id, int32_t cache_id) {
-    register_tracer_generic(4, 2, level, core_id, cache_id, 0, 0, false);
+  inline void register_way_access_tracer(uint32_t level, int32_t core_id, int32_t cache_id) {
+    register_tracer_generic(0, 4, level, core_id, cache_id, 0, 0, false);
+  }
+  // nset: number of sets of the cache (e.g. CacheCFG::nset), the size of the distribution
+  inline void register_set_dist_tracer(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t nset) {
+    register_tracer_generic(4, 2, level, core_id, cache_id, nset, 0, false);
   }
   inline void register_cache_addr_tracer(uint32_t level) {
     register_tracer_generic(1, 0, level, 0, 0, 0, 0, false);
@@ -119,6 +180,25 @@ public:
     register_tracer_generic(3, 3, level, core_id, cache_id, idx, 0, false);
   }
 
+  // periodic reporters: dump the per-interval access counters of a cache (group) to a CSV file,
+  // or to a binary file when `fn' ends with ".bin"; the period is in wall time,
+  // or in the number of cache accesses when wall time is not set; return false if the file cannot be opened
+  inline bool add_cache_reporter(uint32_t level, const std::string &fn, uint64_t period) {
+    return add_reporter_generic(0, level, 0, 0, fn, period);
+  }
+  inline bool add_cache_reporter(uint32_t level, int32_t core_id, const std::string &fn, uint64_t period) {
+    return add_reporter_generic(1, level, core_id, 0, fn, period);
+  }
+  inline bool add_cache_reporter(uint32_t level, int32_t core_id, int32_t cache_id, const std::string &fn, uint64_t period) {
+    return add_reporter_generic(2, level, core_id, cache_id, fn, period);
+  }
+  void flush_reporters();  // dump the current partial interval
+  void remove_reporters(); // flush and close all periodic reporters
+
+  // access monitors, not owned by the reporter
+  void attach_monitor(AccessMonitor *m);
+  void detach_monitor(AccessMonitor *m);
+
   // remove recorders
   inline void remove_cache_access_tracer(uint32_t level) {
     remove_tracer_generic(0, 0, level, 0, 0, 0, 0);
@@ -132,6 +212,9 @@ public:
   inline void remove_set_access_tracer(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) {
     remove_tracer_generic(0, 3, level, core_id, cache_id, idx, 0);
   }
+  inline void remove_way_access_tracer(uint32_t level, int32_t core_id, int32_t cache_id) {
+    remove_tracer_generic(0, 4, level, core_id, cache_id, 0, 0);
+  }
   inline void remove_set_dist_tracer(uint32_t level, int32_t core_id, int32_t cache_id) {
     remove_tracer_generic(4, 2, level, core_id, cache_id, 0, 0);
   }
@@ -173,6 +256,9 @@ public:
   inline void reset_set_access_tracer(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) {
     reset_tracer_generic(0, 3, level, core_id, cache_id, idx, 0);
   }
+  inline void reset_way_access_tracer(uint32_t level, int32_t core_id, int32_t cache_id) {
+    reset_tracer_generic(0, 4, level, core_id, cache_id, 0, 0);
+  }
   inline void reset_set_dist_tracer(uint32_t level, int32_t core_id, int32_t cache_id) {
     reset_tracer_generic(4, 2, level, core_id, cache_id, 0, 0);
   }
@@ -201,12 +287,27 @@ public:
   void clear_state_dbs();
   void clear_addr_traces();
   void clear_set_traces();
+  void clear_set_dist_dbs();
   void clear();
 
   // event recorders
-  void cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state, bool hit);
-  void cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way);
-  void cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way);
+  inline void cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, uint32_t state, bool hit) {
+    if(reporter_enable && db_enable) cache_access_generic(level, core_id, cache_id, addr, idx, way, state, hit);
+  }
+  inline void cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
+    if(reporter_enable && db_enable) cache_evict_generic(level, core_id, cache_id, addr, idx, way);
+  }
+  inline void cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way) {
+    if(reporter_enable && db_enable) cache_writeback_generic(level, core_id, cache_id, addr, idx, way);
+  }
+  inline void cache_request(int32_t core_id, uint32_t op, uint64_t addr) {
+    if(reporter_enable && db_enable) cache_request_generic(core_id, op, addr);
+  }
+
+  // set distribution: fill the per-set counters of a cache and return the number of sets
+  uint64_t check_set_dist(uint32_t level, int32_t core_id, int32_t cache_id, std::vector<uint64_t> *access, std::vector<uint64_t> *miss, std::vector<uint64_t> *evict) const;
+  // export all set distributions to a CSV file, or a binary file when `fn' ends with ".bin"
+  bool export_set_dist(const std::string &fn) const;
 
   // event checkers
   inline bool check_hit(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t *idx, uint32_t *way) const {
@@ -229,9 +330,7 @@ public:
     return check_hit_generic(hash(level), addr);
   }
   bool check_hit(uint64_t addr) const;
-  inline uint64_t check_cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
-    return check_cache_access_generic(hash(level, core_id, cache_id, idx, way));
-  }
+  uint64_t check_cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const;
   inline uint64_t check_cache_access(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
     return check_cache_access_generic(hash(level, core_id, cache_id, idx));
   }
@@ -259,9 +358,7 @@ public:
   inline uint64_t check_addr_access(uint32_t level, uint64_t addr) const {
     return check_addr_access_generic(hash(level), addr);
   }
-  inline uint64_t check_cache_hit(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
-    return check_cache_hit_generic(hash(level, core_id, cache_id, idx, way));
-  }
+  uint64_t check_cache_hit(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const;
   inline uint64_t check_cache_hit(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
     return check_cache_hit_generic(hash(level, core_id, cache_id, idx));
   }
@@ -289,9 +386,7 @@ public:
   inline uint64_t check_addr_hit(uint32_t level, uint64_t addr) const {
     return check_addr_hit_generic(hash(level), addr);
   }
-  inline uint64_t check_cache_miss(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
-    return check_cache_miss_generic(hash(level, core_id, cache_id, idx, way));
-  }
+  uint64_t check_cache_miss(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const;
   inline uint64_t check_cache_miss(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
     return check_cache_miss_generic(hash(level, core_id, cache_id, idx));
   }
@@ -319,9 +414,7 @@ public:
   inline uint64_t check_addr_miss(uint32_t level, uint64_t addr) const {
     return check_addr_miss_generic(hash(level), addr);
   }
-  inline uint64_t check_cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
-    return check_cache_evict_generic(hash(level, core_id, cache_id, idx, way));
-  }
+  uint64_t check_cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const;
   inline uint64_t check_cache_evict(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
     return check_cache_evict_generic(hash(level, core_id, cache_id, idx));
   }
@@ -349,9 +442,7 @@ public:
   inline uint64_t check_addr_evict(uint32_t level, uint64_t addr) const {
     return check_addr_evict_generic(hash(level), addr);
   }
-  inline uint64_t check_cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const {
-    return check_cache_writeback_generic(hash(level, core_id, cache_id, idx, way));
-  }
+  uint64_t check_cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx, uint32_t way) const;
   inline uint64_t check_cache_writeback(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
     return check_cache_writeback_generic(hash(level, core_id, cache_id, idx));
   }
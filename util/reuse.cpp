@@ -0,0 +1,110 @@
+#include "util/reuse.hpp"
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+void StackDistance::compact() {
+  std::vector<std::pair<uint32_t, uint64_t> > order;
+  order.reserve(last.size());
+  for(auto &l : last) order.push_back(std::make_pair(l.second, l.first));
+  std::sort(order.begin(), order.end());
+
+  size_t cap = std::max(tree.size()-1, 2*order.size());
+  tree.assign(cap+1, 0);
+  for(uint32_t i=0; i<order.size(); i++) {
+    last[order[i].second] = i+1;
+    tree[i+1] = 1;
+  }
+  for(uint32_t t=1; t<tree.size(); t++) {   // linear Fenwick build
+    uint32_t p = t + (t & (-t));
+    if(p < tree.size()) tree[p] += tree[t];
+  }
+  now = order.size() + 1;
+}
+
+uint64_t StackDistance::access(uint64_t addr) {
+  if(now >= tree.size()) compact();
+  uint64_t d = cold;
+  auto it = last.find(addr);
+  if(it != last.end()) {
+    d = last.size() - prefix(it->second);
+    add(it->second, -1);
+    it->second = now;
+  } else
+    last[addr] = now;
+  add(now++, 1);
+  return d;
+}
+
+void StackDistance::clear() {
+  last.clear();
+  std::fill(tree.begin(), tree.end(), 0);
+  now = 1;
+}
+
+ReuseHisto::ReuseHisto(uint32_t max, uint32_t stat_bins)
+  : counts(max, 0), overflow(0), n_cold(0), n_total(0),
+    stat(stat_bins ? new HistoStat(stat_bins, 1024) : NULL) {}
+
+void ReuseHisto::record(uint64_t d) {
+  n_total++;
+  if(d == StackDistance::cold) { n_cold++; return; }
+  if(d < counts.size()) counts[d]++;
+  else                  overflow++;
+  if(stat) stat->record(d);
+}
+
+uint64_t ReuseHisto::hits(uint64_t capacity) const {
+  uint64_t rv = 0;
+  for(uint64_t d=0; d<capacity && d<counts.size(); d++) rv += counts[d];
+  return rv;
+}
+
+double ReuseHisto::miss_ratio(uint64_t capacity) const {
+  return n_total ? 1.0 - (double)hits(capacity) / n_total : 0.0;
+}
+
+void ReuseHisto::clear() {
+  std::fill(counts.begin(), counts.end(), 0);
+  overflow = n_cold = n_total = 0;
+}
+
+void ReuseProfiler::track(uint32_t level, int32_t core_id, int32_t cache_id, bool per_set) {
+  assert(!find_cache(profiles, level, core_id, cache_id));
+  profiles.emplace(std::piecewise_construct, std::forward_as_tuple(cache_key(level, core_id, cache_id)),
+                   std::forward_as_tuple(max_dist, stat_bins, per_set));
+}
+
+void ReuseProfiler::access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit) {
+  CacheProfile *pp = find_cache(profiles, level, core_id, cache_id);
+  if(!pp) return;
+  CacheProfile &p = *pp;
+  p.cache_histo.record(p.cache_sd.access(addr));
+  if(p.per_set) {
+    if(idx >= p.set_sd.size()) {
+      p.set_sd.resize(idx+1, StackDistance(64));
+      while(p.set_histo.size() <= idx) p.set_histo.emplace_back(set_max_dist);
+    }
+    p.set_histo[idx].record(p.set_sd[idx].access(addr));
+  }
+}
+
+const ReuseHisto *ReuseProfiler::cache_histo(uint32_t level, int32_t core_id, int32_t cache_id) const {
+  const CacheProfile *p = find_cache(profiles, level, core_id, cache_id);
+  return p ? &(p->cache_histo) : NULL;
+}
+
+const ReuseHisto *ReuseProfiler::set_histo(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const {
+  const CacheProfile *p = find_cache(profiles, level, core_id, cache_id);
+  if(!p || idx >= p->set_histo.size()) return NULL;
+  return &(p->set_histo[idx]);
+}
+
+void ReuseProfiler::clear() {
+  for(auto &p : profiles) {
+    p.second.cache_sd.clear();
+    p.second.cache_histo.clear();
+    for(auto &sd : p.second.set_sd) sd.clear();
+    for(auto &h : p.second.set_histo) h.clear();
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef UTIL_REUSE_HPP_
+#define UTIL_REUSE_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include "util/report.hpp"
+#include "util/statistics.hpp"
+
+// LRU stack distance of an address stream (Olken's algorithm)
+//   the latest access of every address is marked in a Fenwick tree indexed by time,
+//   the distance is the number of marks after the previous access of the address: O(log n)
+//   timestamps are compacted when the tree is full
+class StackDistance
+{
+  std::unordered_map<uint64_t, uint32_t> last;  // address -> time of its latest access
+  std::vector<uint32_t> tree;                   // Fenwick tree over time (1-based)
+  uint32_t now;                                 // the next timestamp
+
+  void add(uint32_t t, int32_t v) {
+    for(; t < tree.size(); t += t & (-t)) tree[t] += v;
+  }
+  uint32_t prefix(uint32_t t) const {
+    uint32_t rv = 0;
+    for(; t > 0; t -= t & (-t)) rv += tree[t];
+    return rv;
+  }
+  void compact();
+
+public:
+  static const uint64_t cold = UINT64_MAX;    // distance of a first access
+
+  StackDistance(uint32_t capacity = 1024) : tree(capacity+1, 0), now(1) {}
+  uint64_t access(uint64_t addr);             // return the stack distance
+  size_t footprint() const { return last.size(); }
+  void clear();
+};
+
+// histogram of stack distances
+class ReuseHisto
+{
+  std::vector<uint64_t> counts;   // counts[d] for distance d < max
+  uint64_t overflow;              // distance >= max
+  uint64_t n_cold;                // first accesses
+  uint64_t n_total;
+  std::unique_ptr<HistoStat> stat; // histogram fed with distances, NULL if none
+
+public:
+  ReuseHisto(uint32_t max, uint32_t stat_bins = 0);
+  void record(uint64_t d);
+  uint64_t total() const { return n_total; }
+  uint64_t cold() const { return n_cold; }
+  uint64_t count(uint64_t d) const { return d < counts.size() ? counts[d] : 0; }
+  uint64_t hits(uint64_t capacity) const;         // hits of an LRU cache (set) holding `capacity' blocks
+  double miss_ratio(uint64_t capacity) const;
+  const HistoStat *histo_stat() const { return stat.get(); } // NULL when not streamed to util/statistics
+  void clear();
+};
+
+// reuse-distance profiler of traced caches, attached to the reporter as an access monitor
+//   distances are counted over the whole cache (fully-associative LRU) and, optionally, per set
+class ReuseProfiler : public AccessMonitor
+{
+  struct CacheProfile {
+    StackDistance cache_sd;
+    ReuseHisto cache_histo;
+    bool per_set;
+    std::vector<StackDistance> set_sd;
+    std::vector<ReuseHisto> set_histo;
+    CacheProfile(uint32_t max, uint32_t stat_bins, bool per_set)
+      : cache_histo(max, stat_bins), per_set(per_set) {}
+  };
+
+  uint32_t max_dist;
+  uint32_t set_max_dist;
+  uint32_t stat_bins;
+  std::unordered_map<uint64_t, CacheProfile> profiles;
+
+public:
+  // max_dist, set_max_dist: distances beyond are only counted as overflow (per cache and per set)
+  // stat_bins: also stream the per-cache distances to util/statistics histograms when non-zero
+  ReuseProfiler(uint32_t max_dist = 1 << 16, uint32_t set_max_dist = 256, uint32_t stat_bins = 0)
+    : max_dist(max_dist), set_max_dist(set_max_dist), stat_bins(stat_bins) {}
+  virtual ~ReuseProfiler() {}
+
+  void track(uint32_t level, int32_t core_id, int32_t cache_id, bool per_set = false);
+  virtual void access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit);
+
+  const ReuseHisto *cache_histo(uint32_t level, int32_t core_id, int32_t cache_id) const;
+  const ReuseHisto *set_histo(uint32_t level, int32_t core_id, int32_t cache_id, uint32_t idx) const;
+  void clear();
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef UTIL_RING_HPP_
+#define UTIL_RING_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+// lock-free single-producer single-consumer ring buffer
+//   the capacity is rounded up to a power of 2
+template<typename T>
+class SPSCRing
+{
+  // head and tail are kept on separate cache lines by padding rather than alignas(64),
+  // which operator new does not honour before C++17
+  std::vector<T> buf;
+  size_t mask;
+  char pad0[64];
+  std::atomic<size_t> head;   // next slot to read, owned by the consumer
+  char pad1[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail;   // next slot to write, owned by the producer
+  char pad2[64 - sizeof(std::atomic<size_t>)];
+
+public:
+  SPSCRing(size_t capacity) : mask(1), head(0), tail(0) {
+    while(mask < capacity) mask <<= 1;
+    buf.resize(mask);
+    mask--;
+  }
+
+  bool push(const T &v) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if(t - head.load(std::memory_order_acquire) > mask) return false; // full
+    buf[t & mask] = v;
+    tail.store(t+1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &v) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if(h == tail.load(std::memory_order_acquire)) return false; // empty
+    v = buf[h & mask];
+    head.store(h+1, std::memory_order_release);
+    return true;
+  }
+
+  // pop up to `max' elements into `out', return the number of popped elements
+  size_t pop_bulk(T *out, size_t max) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t n = tail.load(std::memory_order_acquire) - h;
+    if(n > max) n = max;
+    for(size_t i=0; i<n; i++) out[i] = buf[(h+i) & mask];
+    head.store(h+n, std::memory_order_release);
+    return n;
+  }
+
+  bool empty() const {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+  }
+};
+
+#endif
@@ -1,6 +1,11 @@
 #include "util/statistics.hpp"
 
-#include <map>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/density.hpp>
@@ -11,172 +16,407 @@
 #include <boost/accumulators/statistics/error_of_mean.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
 #include <boost/accumulators/statistics/rolling_variance.hpp>
-using namespace boost::accumulators;
+namespace ba = boost::accumulators;
 
-static uint32_t handles = 0;
-static std::map<uint32_t, void *> db;
-
-typedef accumulator_set<double, stats<tag::mean, tag::error_of<tag::mean>, tag::variance(lazy) > > stat_mean_t;
-typedef accumulator_set<double, stats<tag::rolling_mean, tag::rolling_variance(lazy) > > stat_window_t;
+typedef ba::accumulator_set<double, ba::stats<ba::tag::mean, ba::tag::error_of<ba::tag::mean>, ba::tag::variance(ba::lazy) > > stat_mean_t;
+typedef ba::accumulator_set<double, ba::stats<ba::tag::rolling_mean, ba::tag::rolling_variance(ba::lazy) > > stat_window_t;
 
-typedef accumulator_set<double, stats<tag::density > > stat_histo_t;
+typedef ba::accumulator_set<double, ba::stats<ba::tag::density > > stat_histo_t;
 typedef boost::iterator_range<std::vector<std::pair<double, double> >::iterator > stat_histo_iter_t;
 
-typedef accumulator_set<double, stats<tag::tail_quantile<left> > > stat_tail_left_t;
-typedef accumulator_set<double, stats<tag::tail_quantile<right> > > stat_tail_right_t;
+typedef ba::accumulator_set<double, ba::stats<ba::tag::tail_quantile<ba::left> > > stat_tail_left_t;
+typedef ba::accumulator_set<double, ba::stats<ba::tag::tail_quantile<ba::right> > > stat_tail_right_t;
+
+/////////////////////////////////
+// typed statistics
+
+struct MeanStat::Acc { stat_mean_t s; };
+MeanStat::MeanStat() : acc(new Acc) {}
+MeanStat::~MeanStat() {}
+void MeanStat::record(double sample) { acc->s(sample); }
+uint32_t MeanStat::count() const     { return ba::count(acc->s); }
+double MeanStat::mean() const        { return ba::mean(acc->s); }
+double MeanStat::error() const       { return ba::error_of<ba::tag::mean>(acc->s); }
+double MeanStat::variance() const    { return ba::variance(acc->s); }
+
+struct WindowStat::Acc {
+  stat_window_t s;
+  Acc(uint32_t window) : s(ba::tag::rolling_window::window_size = window) {}
+};
+WindowStat::WindowStat(uint32_t window) : acc(new Acc(window)) {}
+WindowStat::~WindowStat() {}
+void WindowStat::record(double sample) { acc->s(sample); }
+uint32_t WindowStat::count() const     { return ba::rolling_count(acc->s); }
+double WindowStat::mean() const        { return ba::rolling_mean(acc->s); }
+double WindowStat::variance() const    { return ba::rolling_variance(acc->s); }
+
+struct HistoStat::Acc {
+  stat_histo_t s;
+  Acc(uint32_t binN, uint32_t cacheS) : s(ba::tag::density::num_bins = binN, ba::tag::density::cache_size = cacheS) {}
+};
+HistoStat::HistoStat(uint32_t binN, uint32_t cacheS) : acc(new Acc(binN, cacheS)) {}
+HistoStat::~HistoStat() {}
+void HistoStat::record(double sample) { acc->s(sample); }
+uint32_t HistoStat::count() const     { return ba::count(acc->s); }
+std::vector<std::pair<double, double> > HistoStat::density() const {
+  stat_histo_iter_t hist = ba::density(acc->s);
+  return std::vector<std::pair<double, double> >(hist.begin(), hist.end());
+}
+
+struct TailStat::Acc {
+  std::unique_ptr<stat_tail_left_t>  l;
+  std::unique_ptr<stat_tail_right_t> r;
+};
+TailStat::TailStat(bool dir, uint32_t cacheS) : acc(new Acc), dir(dir) {
+  if(dir) acc->r.reset(new stat_tail_right_t(ba::tag::tail<ba::right>::cache_size = cacheS));
+  else    acc->l.reset(new stat_tail_left_t(ba::tag::tail<ba::left>::cache_size = cacheS));
+}
+TailStat::~TailStat() {}
+void TailStat::record(double sample) {
+  if(dir) (*acc->r)(sample);
+  else    (*acc->l)(sample);
+}
+double TailStat::quantile(double ratio) const {
+  if(dir) {
+    assert(ratio >= 0.5);
+    return ba::quantile(*acc->r, ba::quantile_probability = ratio);
+  } else {
+    assert(ratio <= 0.5);
+    return ba::quantile(*acc->l, ba::quantile_probability = ratio);
+  }
+}
+
+/////////////////////////////////
+// sharded mean statistics
+
+static std::atomic<uint32_t> sharded_ids(0);
+static thread_local std::vector<void *> local_shards;  // indexed by the id of a ShardedMeanStat
+
+ShardedMeanStat::ShardedMeanStat() : id(sharded_ids++) {}
+
+ShardedMeanStat::Shard *ShardedMeanStat::new_shard() {
+  std::lock_guard<std::mutex> lock(mtx);
+  shards.push_back(std::unique_ptr<Shard>(new Shard));
+  if(id >= local_shards.size()) local_shards.resize(id+1, NULL);
+  local_shards[id] = shards.back().get();
+  return shards.back().get();
+}
+
+void ShardedMeanStat::record(double sample) {
+  Shard *s = id < local_shards.size() ? (Shard *)local_shards[id] : NULL;
+  if(!s) s = new_shard();
+  s->n++;   // Welford's update
+  double delta = sample - s->mean;
+  s->mean += delta / s->n;
+  s->m2 += delta * (sample - s->mean);
+}
+
+ShardedMeanStat::Shard ShardedMeanStat::merge() const {
+  Shard rv;
+  for(auto &s : shards) {  // Chan's parallel merge
+    if(!s->n) continue;
+    uint64_t n = rv.n + s->n;
+    double delta = s->mean - rv.mean;
+    rv.mean += delta * s->n / n;
+    rv.m2 += s->m2 + delta * delta * rv.n * s->n / n;
+    rv.n = n;
+  }
+  return rv;
+}
+
+uint32_t ShardedMeanStat::count() const { return merge().n; }
+double ShardedMeanStat::mean() const    { Shard s = merge(); return s.n ? s.mean : NAN; }
+double ShardedMeanStat::variance() const { Shard s = merge(); return s.n ? s.m2 / s.n : NAN; }
+double ShardedMeanStat::error() const { // same as boost error_of<mean>
+  Shard s = merge();
+  if(s.n < 2) return NAN;
+  return std::sqrt(s.m2 / s.n / (s.n - 1));
+}
+
+void ShardedMeanStat::clear() {
+  std::lock_guard<std::mutex> lock(mtx);
+  for(auto &s : shards) *s = Shard();
+}
+
+/////////////////////////////////
+// quantile sketch
+
+QuantileSketch::QuantileSketch(double compression)
+  : compression(compression), total(0), min(INFINITY), max(-INFINITY)
+{
+  buffer.reserve(5 * compression);
+}
+
+void QuantileSketch::add(double mean, double weight) {
+  if(mean < min) min = mean;
+  if(mean > max) max = mean;
+  buffer.push_back({mean, weight});
+  if(buffer.size() >= 5 * compression) compress();
+}
+
+// merge neighbouring centroids while they span at most one unit of the k1 scale function
+void QuantileSketch::compress() const {
+  if(buffer.empty()) return;
+  buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+  std::sort(buffer.begin(), buffer.end());
+  double w = 0;
+  for(auto &c : buffer) w += c.weight;
+
+  auto k = [this](double q) { return compression / (2 * M_PI) * std::asin(2 * q - 1); };
+  centroids.clear();
+  Centroid cur = buffer[0];
+  double w_done = 0, k_lo = k(0);
+  for(size_t i=1; i<buffer.size(); i++) {
+    const Centroid &c = buffer[i];
+    if(k(std::min(1.0, (w_done + cur.weight + c.weight) / w)) - k_lo <= 1) {
+      cur.weight += c.weight;
+      cur.mean += (c.mean - cur.mean) * c.weight / cur.weight;
+    } else {
+      centroids.push_back(cur);
+      w_done += cur.weight;
+      k_lo = k(std::min(1.0, w_done / w));
+      cur = c;
+    }
+  }
+  centroids.push_back(cur);
+  total = w;
+  buffer.clear();
+}
+
+// the centroids of `s' join the buffer as they are, the next compress() recounts the total weight
+void QuantileSketch::merge(const QuantileSketch &s) {
+  if(&s == this) { QuantileSketch c(s); merge(c); return; }
+  buffer.insert(buffer.end(), s.centroids.begin(), s.centroids.end());
+  buffer.insert(buffer.end(), s.buffer.begin(), s.buffer.end());
+  min = std::min(min, s.min);
+  max = std::max(max, s.max);
+  if(buffer.size() >= 5 * compression) compress();
+}
+
+uint64_t QuantileSketch::count() const {
+  double w = total;
+  for(auto &c : buffer) w += c.weight;
+  return (uint64_t)(w + 0.5);
+}
+
+double QuantileSketch::quantile(double q) const {
+  compress();
+  if(centroids.empty()) return NAN;
+  if(q <= 0) return min;
+  if(q >= 1) return max;
+  if(centroids.size() == 1) return centroids[0].mean;
+
+  double idx = q * total;
+  const Centroid &first = centroids.front(), &last = centroids.back();
+  if(idx < first.weight / 2)   // between the minimum and the center of the first centroid
+    return min + (first.mean - min) * idx / (first.weight / 2);
+
+  double w = 0;
+  for(size_t i=0; i+1<centroids.size(); i++) {
+    const Centroid &a = centroids[i], &b = centroids[i+1];
+    double left = w + a.weight / 2, right = w + a.weight + b.weight / 2;
+    if(idx < right) return a.mean + (b.mean - a.mean) * (idx - left) / (right - left);
+    w += a.weight;
+  }
+
+  double z = idx - (total - last.weight / 2);  // after the center of the last centroid
+  return last.mean + (max - last.mean) * z / (last.weight / 2);
+}
+
+// format: compression, min, max, number of centroids, then (mean, weight) pairs, all as doubles
+std::string QuantileSketch::serialize() const {
+  compress();
+  std::vector<double> v = {compression, min, max, (double)centroids.size()};
+  for(auto &c : centroids) { v.push_back(c.mean); v.push_back(c.weight); }
+  return std::string((const char *)v.data(), v.size() * sizeof(double));
+}
+
+bool QuantileSketch::deserialize(const std::string &data, QuantileSketch *s) {
+  if(data.size() < 4 * sizeof(double) || data.size() % sizeof(double)) return false;
+  std::vector<double> v(data.size() / sizeof(double));
+  memcpy(v.data(), data.data(), data.size());
+  // validate before any conversion: an out-of-range double to size_t is undefined
+  if(!(v[0] > 0 && v[0] <= 1e6)) return false;          // also bounds buffer.reserve()
+  size_t cap = (v.size() - 4) / 2;
+  if(!(v[3] >= 0) || v[3] != std::floor(v[3]) || v[3] > cap) return false;
+  size_t n = v[3];
+  if(v.size() != 4 + 2*n) return false;
+  for(size_t i=0; i<n; i++)
+    if(!std::isfinite(v[4+2*i]) || !std::isfinite(v[5+2*i]) || !(v[5+2*i] > 0)) return false;
+  *s = QuantileSketch(v[0]);
+  for(size_t i=0; i<n; i++) s->add(v[4+2*i], v[5+2*i]);
+  if(n) { s->min = v[1]; s->max = v[2]; }
+  s->compress();
+  return true;
+}
+
+void QuantileSketch::clear() {
+  centroids.clear();
+  buffer.clear();
+  total = 0;
+  min = INFINITY;
+  max = -INFINITY;
+}
+
+SampledRatioStat::SampledRatioStat(uint64_t population)
+  : population(population), n(0), sx(0), sy(0), sxx(0), syy(0), sxy(0) {}
+
+void SampledRatioStat::record(double x, double y) {
+  n++;
+  sx += x; sy += y;
+  sxx += x*x; syy += y*y; sxy += x*y;
+}
+
+double SampledRatioStat::ratio() const {
+  return sy > 0 ? sx / sy : NAN;
+}
+
+double SampledRatioStat::error() const {
+  if(n < 2 || sy <= 0) return NAN;
+  // linearized variance of the ratio estimator: sum (x - r*y)^2 / (n-1) / (n * mean(y)^2)
+  double r = sx / sy;
+  double my = sy / n;
+  double s2 = std::max(0.0, sxx - 2*r*sxy + r*r*syy) / (n - 1);
+  double fpc = population > n ? 1.0 - (double)n / population : (population ? 0.0 : 1.0);
+  return std::sqrt(fpc * s2 / n) / my;
+}
+
+std::pair<double, double> SampledRatioStat::interval(double z) const {
+  double r = ratio(), e = error();
+  return std::make_pair(r - z*e, r + z*e);
+}
+
+/////////////////////////////////
+// legacy handle interface
+
+static std::mutex db_mtx;
+static uint32_t handles = 0;
+static std::unordered_map<uint32_t, MeanStat>   mean_db;
+static std::unordered_map<uint32_t, WindowStat> window_db;
+static std::unordered_map<uint32_t, HistoStat>  histo_db;
+static std::unordered_map<uint32_t, TailStat>   tail_db;
+
+template<typename T>
+static T &lookup(std::unordered_map<uint32_t, T> &db, uint32_t handle) {
+  auto it = db.find(handle);
+  assert(it != db.end());
+  return it->second;
+}
 
 uint32_t init_mean_stat() {
-  db[handles] = (void *)(new stat_mean_t());
+  std::lock_guard<std::mutex> lock(db_mtx);
+  mean_db.insert(std::make_pair(handles, MeanStat()));
   return handles++;
 }
 
 uint32_t init_window_stat(uint32_t window) {
-  db[handles] = (void *)(new stat_window_t(tag::rolling_window::window_size = window));
+  std::lock_guard<std::mutex> lock(db_mtx);
+  window_db.insert(std::make_pair(handles, WindowStat(window)));
   return handles++;
 }
 
 uint32_t init_histo_stat(uint32_t binN, uint32_t cacheS) {
-  db[handles] = (void *)(new stat_histo_t(tag::density::num_bins = binN,
-                                             tag::density::cache_size = cacheS));
+  std::lock_guard<std::mutex> lock(db_mtx);
+  histo_db.insert(std::make_pair(handles, HistoStat(binN, cacheS)));
   return handles++;
 }
 
 uint32_t init_tail_stat(bool dir, uint32_t cacheS) {
-  if(dir)
-    db[handles] = (void *)(new stat_tail_left_t(tag::tail<left>::cache_size = cacheS));
-  else
-    db[handles] = (void *)(new stat_tail_right_t(tag::tail<right>::cache_size = cacheS));
+  std::lock_guard<std::mutex> lock(db_mtx);
+  tail_db.insert(std::make_pair(handles, TailStat(dir, cacheS)));
   return handles++;
 }
 
 void record_mean_stat(uint32_t handle, double sample) {
-  assert(db.count(handle));
-  stat_mean_t *stat = (stat_mean_t *)(db[handle]);
-  (*stat)(sample);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  lookup(mean_db, handle).record(sample);
 }
 
 void record_window_stat(uint32_t handle, double sample) {
-  assert(db.count(handle));
-  stat_window_t *stat = (stat_window_t *)(db[handle]);
-  (*stat)(sample);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  lookup(window_db, handle).record(sample);
 }
 
 void record_histo_stat(uint32_t handle, double sample) {
-  assert(db.count(handle));
-  stat_histo_t *stat = (stat_histo_t *)(db[handle]);
-  (*stat)(sample);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  lookup(histo_db, handle).record(sample);
 }
 
 void record_tail_stat(uint32_t handle, bool dir, double sample) {
-  assert(db.count(handle));
-  if(dir) {
-    stat_tail_right_t *stat = (stat_tail_right_t *)(db[handle]);
-    (*stat)(sample);
-  } else {
-    stat_tail_left_t *stat = (stat_tail_left_t *)(db[handle]);
-    (*stat)(sample);
-  }
+  std::lock_guard<std::mutex> lock(db_mtx);
+  lookup(tail_db, handle).record(sample);
 }
 
 uint32_t get_mean_count(uint32_t handle) {
-  assert(db.count(handle));
-  stat_mean_t *stat = (stat_mean_t *)(db[handle]);
-  return count(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(mean_db, handle).count();
 }
 
 double get_mean_mean(uint32_t handle) {
-  assert(db.count(handle));
-  stat_mean_t *stat = (stat_mean_t *)(db[handle]);
-  return mean(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(mean_db, handle).mean();
 }
 
 double get_mean_error(uint32_t handle) {
-  assert(db.count(handle));
-  stat_mean_t *stat = (stat_mean_t *)(db[handle]);
-  return error_of<tag::mean>(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(mean_db, handle).error();
 }
 
 double get_mean_variance(uint32_t handle) {
-  assert(db.count(handle));
-  stat_mean_t *stat = (stat_mean_t *)(db[handle]);
-  return variance(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(mean_db, handle).variance();
 }
 
 uint32_t get_window_count(uint32_t handle) {
-  assert(db.count(handle));
-  stat_window_t *stat = (stat_window_t *)(db[handle]);
-  return rolling_count(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(window_db, handle).count();
 }
 
 double get_window_mean(uint32_t handle) {
-  assert(db.count(handle));
-  stat_window_t *stat = (stat_window_t *)(db[handle]);
-  return rolling_mean(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(window_db, handle).mean();
 }
 
 double get_window_variance(uint32_t handle) {
-  assert(db.count(handle));
-  stat_window_t *stat = (stat_window_t *)(db[handle]);
-  return rolling_variance(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(window_db, handle).variance();
 }
 
 uint32_t get_histo_count(uint32_t handle) {
-  assert(db.count(handle));
-  stat_histo_t *stat = (stat_histo_t *)(db[handle]);
-  return count(*stat);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(histo_db, handle).count();
 }
 
 std::vector<std::pair<double, double> > get_histo_density(uint32_t handle) {
-  assert(db.count(handle));
-  stat_histo_t *stat = (stat_histo_t *)(db[handle]);
-  stat_histo_iter_t hist = density(*stat);
-  std::vector<std::pair<double, double> > rv(hist.size());
-  for(uint32_t i=0; i<hist.size(); i++) rv[i] = hist[i];
-  return rv;
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(histo_db, handle).density();
 }
 
 double get_tail_quantile(uint32_t handle, bool dir, double ratio) {
-  assert(db.count(handle));
-  if(dir) {
-    stat_tail_right_t *stat = (stat_tail_right_t *)(db[handle]);
-    assert(ratio >= 0.5);
-    return quantile(*stat, quantile_probability = ratio);
-  } else {
-    stat_tail_left_t *stat = (stat_tail_left_t *)(db[handle]);
-    assert(ratio <= 0.5);
-    return quantile(*stat, quantile_probability = ratio);
-  }
+  std::lock_guard<std::mutex> lock(db_mtx);
+  return lookup(tail_db, handle).quantile(ratio);
 }
 
 void close_mean_stat(uint32_t handle) {
-  assert(db.count(handle));
-  stat_mean_t *stat = (stat_mean_t *)(db[handle]);
-  delete stat;
-  db.erase(handle);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  assert(mean_db.count(handle));
+  mean_db.erase(handle);
 }
 
 void close_window_stat(uint32_t handle) {
-  assert(db.count(handle));
-  stat_window_t *stat = (stat_window_t *)(db[handle]);
-  delete stat;
-  db.erase(handle);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  assert(window_db.count(handle));
+  window_db.erase(handle);
 }
 
 void close_histo_stat(uint32_t handle) {
-  assert(db.count(handle));
-  stat_histo_t *stat = (stat_histo_t *)(db[handle]);
-  delete stat;
-  db.erase(handle);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  assert(histo_db.count(handle));
+  histo_db.erase(handle);
 }
 
 void close_tail_stat(uint32_t handle, bool dir) {
-  assert(db.count(handle));
-  if(dir) {
-    stat_tail_right_t *stat = (stat_tail_right_t *)(db[handle]);
-    delete stat;
-  } else {
-    stat_tail_left_t *stat = (stat_tail_left_t *)(db[handle]);
-    delete stat;
-  }
-  db.erase(handle);
+  std::lock_guard<std::mutex> lock(db_mtx);
+  assert(tail_db.count(handle));
+  tail_db.erase(handle);
 }
@@ -4,6 +4,153 @@
 #include <cstdint>
 #include <vector>
 #include <utility>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// typed statistics, each object owns its boost accumulator
+
+class MeanStat
+{
+  struct Acc;
+  std::unique_ptr<Acc> acc;
+public:
+  MeanStat();
+  ~MeanStat();
+  MeanStat(MeanStat &&) = default;
+  MeanStat &operator=(MeanStat &&) = default;
+  void record(double sample);
+  uint32_t count() const;
+  double mean() const;
+  double error() const;
+  double variance() const;
+};
+
+class WindowStat
+{
+  struct Acc;
+  std::unique_ptr<Acc> acc;
+public:
+  WindowStat(uint32_t window);
+  ~WindowStat();
+  WindowStat(WindowStat &&) = default;
+  WindowStat &operator=(WindowStat &&) = default;
+  void record(double sample);
+  uint32_t count() const;
+  double mean() const;
+  double variance() const;
+};
+
+class HistoStat
+{
+  struct Acc;
+  std::unique_ptr<Acc> acc;
+public:
+  HistoStat(uint32_t binN, uint32_t cacheS);
+  ~HistoStat();
+  HistoStat(HistoStat &&) = default;
+  HistoStat &operator=(HistoStat &&) = default;
+  void record(double sample);
+  uint32_t count() const;
+  std::vector<std::pair<double, double> > density() const;
+};
+
+// dir: true for the right (upper) tail, quantile ratio >= 0.5
+//      false for the left (lower) tail, quantile ratio <= 0.5
+class TailStat
+{
+  struct Acc;
+  std::unique_ptr<Acc> acc;
+  bool dir;
+public:
+  TailStat(bool dir, uint32_t cacheS);
+  ~TailStat();
+  TailStat(TailStat &&) = default;
+  TailStat &operator=(TailStat &&) = default;
+  void record(double sample);
+  double quantile(double ratio) const;
+};
+
+// Mean statistics recorded by multiple threads without locks.
+//   Every thread records to its own shard (count, mean and sum of squared deviations),
+//   found by the stat id in a thread-local vector. Shards are merged on read, which
+//   should not run concurrently with recording.
+class ShardedMeanStat
+{
+  struct Shard {
+    uint64_t n;
+    double mean, m2;
+    Shard() : n(0), mean(0.0), m2(0.0) {}
+  };
+
+  const uint32_t id;
+  std::mutex mtx;                          // protects `shards' when a thread adds its shard
+  std::vector<std::unique_ptr<Shard> > shards;
+
+  Shard *new_shard();
+  Shard merge() const;
+
+public:
+  ShardedMeanStat();
+  void record(double sample);
+  uint32_t count() const;
+  double mean() const;
+  double error() const;
+  double variance() const;
+  void clear();
+};
+
+// Mergeable streaming quantile sketch (merging t-digest).
+//   Samples are buffered and merged into at most about `compression' centroids,
+//   small centroids at both ends keep the extreme quantiles (p99, p99.9) accurate.
+//   Sketches from other threads or processes (via serialize()) can be merged in.
+class QuantileSketch
+{
+  struct Centroid {
+    double mean, weight;
+    bool operator<(const Centroid &c) const { return mean < c.mean; }
+  };
+
+  double compression;
+  mutable std::vector<Centroid> centroids;   // sorted by mean
+  mutable std::vector<Centroid> buffer;      // unmerged samples
+  mutable double total;                      // weight of the centroids
+  double min, max;
+
+  void compress() const;                     // folds the buffer into the centroids, same distribution
+  void add(double mean, double weight);
+
+public:
+  QuantileSketch(double compression = 100);
+  void record(double sample) { add(sample, 1.0); }
+  void merge(const QuantileSketch &s);
+  uint64_t count() const;
+  // NaN when empty. Reading compresses the buffer in place: like recording,
+  // it must not run concurrently with any other call on the same sketch.
+  double quantile(double q) const;
+  std::string serialize() const;
+  static bool deserialize(const std::string &data, QuantileSketch *s);
+  void clear();
+};
+
+// Ratio of two totals (e.g. misses/accesses) estimated from a random sample of clusters
+// (e.g. cache sets), each sampled cluster contributing a (numerator, denominator) pair.
+//   The population is the number of clusters sampled from, used for the finite population correction.
+class SampledRatioStat
+{
+  uint64_t population, n;
+  double sx, sy, sxx, syy, sxy;
+public:
+  SampledRatioStat(uint64_t population = 0);
+  void add_population(uint64_t p) { population += p; }
+  void record(double x, double y);
+  uint64_t count() const { return n; }
+  double ratio() const;                                       // NaN when empty
+  double error() const;                                       // standard error of ratio()
+  std::pair<double, double> interval(double z = 1.96) const;  // confidence interval, 95% by default
+};
+
+// legacy interface on handles, safe to call from multiple threads (serialized by a global mutex)
 
 extern uint32_t init_mean_stat();
 extern uint32_t init_window_stat(uint32_t window);
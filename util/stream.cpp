@@ -0,0 +1,63 @@
+#include "util/stream.hpp"
+#include <csignal>
+#include <sys/wait.h>
+
+static std::string quote(const std::string &fn) {
+  std::string rv = "'";
+  for(auto c : fn) {
+    if(c == '\'') rv += "'\\''";
+    else          rv += c;
+  }
+  return rv + "'";
+}
+
+static bool ends_with(const std::string &s, const std::string &suffix) {
+  return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static std::string ext_compress(const std::string &fn) {
+  if(ends_with(fn, ".gz") ) return "gzip";
+  if(ends_with(fn, ".xz") ) return "xz";
+  if(ends_with(fn, ".zst")) return "zstd";
+  if(ends_with(fn, ".lz4")) return "lz4";
+  return "";
+}
+
+FILE *open_stream(const std::string &fn, bool write, bool *piped, const std::string &compress) {
+  std::string method = compress.empty() ? ext_compress(fn) : compress;
+  std::string cmd;
+  if     (method == "gzip") cmd = "gzip -c";
+  else if(method == "xz"  ) cmd = "xz -c";
+  else if(method == "zstd") cmd = "zstd -q -c";
+  else if(method == "lz4" ) cmd = "lz4 -q -c";
+  else if(!method.empty()) return NULL;
+  if(!cmd.empty()) cmd += write ? " > " : " -d < ";
+
+  *piped = !cmd.empty();
+  if(*piped) {
+    if(write) {
+      // the shell redirect fails after popen() returns, check the output file can be created first
+      FILE *fp = fopen(fn.c_str(), "wb");
+      if(!fp) return NULL;
+      fclose(fp);
+      // a compressor failing later turns the writes into EPIPE errors instead of killing the process
+      signal(SIGPIPE, SIG_IGN);
+    }
+    return popen((cmd + quote(fn)).c_str(), write ? "w" : "r");
+  }
+  else if(fn == "-")
+    return write ? stdout : stdin;
+  else
+    return fopen(fn.c_str(), write ? "wb" : "rb");
+}
+
+bool close_stream(FILE *fp, bool piped) {
+  if(!fp) return true;
+  bool rv = fflush(fp) == 0 && !ferror(fp);
+  if(piped) {
+    int status = pclose(fp);
+    rv = rv && status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  } else if(fp != stdout && fp != stdin)
+    rv = fclose(fp) == 0 && rv;
+  return rv;
+}
@@ -0,0 +1,17 @@
+#ifndef UTIL_STREAM_HPP_
+#define UTIL_STREAM_HPP_
+
+#include <cstdio>
+#include <string>
+
+// Open a file for streaming read or write.
+// Compression is handled by piping through an external tool (gzip, xz, zstd or lz4):
+// it is given by `compress' or, when `compress' is empty, recognized from the file extension
+// (.gz, .xz, .zst, .lz4). "-" opens stdin/stdout.
+// `piped' returns whether the stream must be closed by close_stream() as a pipe.
+// Writing through a compressor ignores SIGPIPE, so a failed compressor shows up as write errors.
+extern FILE *open_stream(const std::string &fn, bool write, bool *piped, const std::string &compress = "");
+// return false when a write failed or the compressor did not exit successfully
+extern bool close_stream(FILE *fp, bool piped);
+
+#endif
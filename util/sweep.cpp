@@ -0,0 +1,53 @@
+#include "util/sweep.hpp"
+#include "cache/cache.hpp"
+#include <boost/format.hpp>
+
+LRUSweep::~LRUSweep() {}
+
+uint32_t LRUSweep::add_config(uint32_t nset, uint32_t nway) {
+  uint32_t gi = 0;
+  while(gi < groups.size() && groups[gi].nset != nset) gi++;
+  if(gi == groups.size()) {
+    groups.resize(gi+1);
+    SetGroup &g = groups[gi];
+    g.nset = nset;
+    g.indexer.reset(ic(nset));
+    g.slots.assign(nset, -1);
+    for(uint32_t i=0; i<nset; i++)
+      if(CacheBase::sampled(i, sample)) { g.slots[i] = g.sets.size(); g.sets.push_back(StackDistance(64)); }
+  }
+  groups[gi].configs.push_back(configs.size());
+  configs.push_back(std::make_pair(gi, Config(nway)));
+  return configs.size() - 1;
+}
+
+void LRUSweep::access(uint64_t addr) {
+  for(auto &g : groups) {
+    int32_t slot = g.slots[g.indexer->index(NULL, addr)];
+    if(slot < 0) continue;
+    StackDistance &sd = g.sets[slot];
+    uint64_t footprint = sd.footprint();
+    uint64_t d = sd.access(addr);
+    for(auto ci : g.configs) {
+      Config &c = configs[ci].second;
+      c.n_access++;
+      if(d < c.nway) c.n_hit++;
+      else if(footprint >= c.nway) c.n_evict++;
+    }
+  }
+}
+
+std::string LRUSweep::to_string() const {
+  std::string rv;
+  for(uint32_t i=0; i<configs.size(); i++)
+    rv += (boost::format("%1% %2% %3% %4% %5% %6%\n")
+           % get_nset(i) % get_nway(i) % get_access(i) % get_hit(i) % get_miss(i) % get_evict(i)).str();
+  return rv;
+}
+
+void LRUSweep::clear() {
+  for(auto &g : groups)
+    for(auto &sd : g.sets) sd.clear();
+  for(auto &c : configs)
+    c.second.n_access = c.second.n_hit = c.second.n_evict = 0;
+}
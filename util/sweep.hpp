@@ -0,0 +1,73 @@
+#ifndef UTIL_SWEEP_HPP_
+#define UTIL_SWEEP_HPP_
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "cache/definitions.hpp"
+#include "util/report.hpp"
+#include "util/reuse.hpp"
+
+// Single-pass simulation of a family of LRU caches (Mattson's stack algorithm).
+//   Configurations with the same number of sets share one stack distance per set,
+//   an access hits every configuration whose associativity is larger than its distance.
+//   With sampling, only the sets chosen by CacheBase::sampled() (about 1/`sample') are simulated
+//   and the counters are scaled up by the ratio of all sets to simulated sets.
+// Writebacks are not modelled, as the stack algorithm does not keep the dirty state per configuration.
+class LRUSweep : public AccessMonitor
+{
+  struct Config {
+    uint32_t nway;
+    uint64_t n_access, n_hit, n_evict;
+    Config(uint32_t nway) : nway(nway), n_access(0), n_hit(0), n_evict(0) {}
+  };
+
+  struct SetGroup {
+    uint32_t nset;
+    std::unique_ptr<IndexFuncBase> indexer;
+    std::vector<int32_t> slots;      // set index -> simulated set in `sets', -1 if not sampled
+    std::vector<StackDistance> sets;
+    std::vector<uint32_t> configs;   // indices to `configs'
+    uint64_t scale(uint64_t n) const { return sets.empty() ? 0 : (n * nset + sets.size() / 2) / sets.size(); }
+  };
+
+  indexer_creator_t ic;
+  uint32_t sample;
+  std::vector<SetGroup> groups;
+  std::vector<std::pair<uint32_t, Config> > configs; // (group, config)
+
+  bool monitored;
+  uint32_t m_level;
+  int32_t m_core_id, m_cache_id;
+
+public:
+  LRUSweep(indexer_creator_t ic, uint32_t sample = 1)
+    : ic(ic), sample(sample), monitored(false) {}
+  LRUSweep(const LRUSweep &) = delete;
+  LRUSweep &operator=(const LRUSweep &) = delete;
+  virtual ~LRUSweep();
+
+  uint32_t add_config(uint32_t nset, uint32_t nway);   // return the config id
+
+  // feed the sweep with the accesses of a cache when attached to the reporter
+  void monitor(uint32_t level, int32_t core_id, int32_t cache_id) {
+    monitored = true; m_level = level; m_core_id = core_id; m_cache_id = cache_id;
+  }
+  virtual void access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit) {
+    if(monitored && level == m_level && core_id == m_core_id && cache_id == m_cache_id) access(addr);
+  }
+  void access(uint64_t addr);
+
+  // counters of a configuration, same as DBAccType
+  size_t size() const { return configs.size(); }
+  uint32_t get_nset(uint32_t id) const      { return groups[configs[id].first].nset; }
+  uint32_t get_nway(uint32_t id) const      { return configs[id].second.nway; }
+  uint64_t get_access(uint32_t id) const    { return groups[configs[id].first].scale(configs[id].second.n_access); }
+  uint64_t get_hit(uint32_t id) const       { return groups[configs[id].first].scale(configs[id].second.n_hit); }
+  uint64_t get_miss(uint32_t id) const      { return get_access(id) - get_hit(id); }
+  uint64_t get_evict(uint32_t id) const     { return groups[configs[id].first].scale(configs[id].second.n_evict); }
+  std::string to_string() const;  // one line per configuration: nset nway access hit miss evict
+  void clear();
+};
+
+#endif
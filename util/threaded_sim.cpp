@@ -0,0 +1,138 @@
+#include "util/threaded_sim.hpp"
+#include "cache/cache.hpp"
+#include "util/report.hpp"
+#include <thread>
+
+void ThreadedHierarchy::Barrier::wait() {
+  std::unique_lock<std::mutex> lk(mtx);
+  uint32_t g = generation;
+  if(++waiting == count) {
+    waiting = 0;
+    generation++;
+    cv.notify_all();
+  } else
+    cv.wait(lk, [this, g] { return generation != g; });
+}
+
+ThreadedHierarchy::ThreadedHierarchy(const std::vector<CoherentCache *> &l1_caches)
+  : counters(l1_caches.size()), records(NULL), n(0), earliest(0), position(0), finished(false)
+{
+  for(auto c : l1_caches) l1.push_back((L1CacheBase *)c);
+  pthread_rwlockattr_t attr;
+  pthread_rwlockattr_init(&attr);
+  // misses should not starve behind a stream of L1 hits
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&lock, &attr);
+  pthread_rwlockattr_destroy(&attr);
+}
+
+ThreadedHierarchy::~ThreadedHierarchy() {
+  pthread_rwlock_destroy(&lock);
+}
+
+bool ThreadedHierarchy::local(const TraceRecord &r) const {
+  return r.op != TraceRecord::FLUSH && l1[r.core]->local(r.addr, r.op == TraceRecord::WRITE);
+}
+
+void ThreadedHierarchy::exec(const TraceRecord &r, bool local) {
+  L1CacheBase *cache = l1[r.core];
+  if(r.op == TraceRecord::FLUSH) {
+    cache->flush(r.addr);
+    return;
+  }
+  Counters &cnt = counters[r.core];
+  bool hit;
+  if(r.op == TraceRecord::READ) cache->read_batch(&r.addr, 1, NULL, &hit);
+  else                          cache->write_batch(&r.addr, 1, NULL, &hit);
+  cnt.access++;
+  if(local) cnt.local++;
+  else if(!hit) cnt.miss++;
+}
+
+void ThreadedHierarchy::run_free(uint32_t core) {
+  for(auto pos : lists[core]) {
+    const TraceRecord &r = records[pos];
+    pthread_rwlock_rdlock(&lock);
+    bool l = local(r);
+    if(l) exec(r, true);
+    pthread_rwlock_unlock(&lock);
+    if(l) continue;
+    pthread_rwlock_wrlock(&lock);
+    exec(r, false);
+    pthread_rwlock_unlock(&lock);
+  }
+}
+
+// simulate the records from `from' in order on the calling thread,
+// stop after a run of L1-local accesses that can be handed back to the core threads
+void ThreadedHierarchy::serial(size_t from) {
+  const uint32_t max_local_run = 256;
+  uint32_t run = 0;
+  size_t pos = from;
+  while(pos < n && run < max_local_run) {
+    const TraceRecord &r = records[pos++];
+    if(!valid(r)) continue;
+    bool l = local(r);
+    run = l ? run + 1 : 0;
+    exec(r, l);
+  }
+  position = pos;
+  earliest = n;
+  finished = pos >= n;
+}
+
+void ThreadedHierarchy::run_ordered(uint32_t core) {
+  auto &list = lists[core];
+  size_t &cur = cursors[core];
+  while(true) {
+    // find the first access of this core that is not L1-local, no need to look beyond the earliest found
+    while(cur < list.size() && list[cur] < position) cur++;
+    for(size_t k = cur; k < list.size() && list[k] < earliest; k++)
+      if(!local(records[list[k]])) {
+        size_t e = earliest;
+        while(list[k] < e && !earliest.compare_exchange_weak(e, list[k]));
+        break;
+      }
+    barrier.wait();
+
+    // the L1-local accesses before the earliest other access only touch their own L1
+    size_t end = earliest;
+    for(; cur < list.size() && list[cur] < end; cur++) exec(records[list[cur]], true);
+    barrier.wait();
+
+    if(core == 0) serial(end);
+    barrier.wait();
+    if(finished) break;
+  }
+}
+
+uint64_t ThreadedHierarchy::replay(const TraceRecord *records, size_t n, bool deterministic) {
+  this->records = records;
+  this->n = n;
+  lists.assign(l1.size(), std::vector<size_t>());
+  uint64_t rv = 0;
+  for(size_t i=0; i<n; i++)
+    if(valid(records[i])) {
+      lists[records[i].core].push_back(i);
+      rv++;
+    }
+
+  if(reporter.enabled()) {
+    // the reporter is per thread, events are only recorded by the calling thread
+    serial(0);
+    while(!finished) serial(position);
+    return rv;
+  }
+
+  cursors.assign(l1.size(), 0);
+  earliest = n;
+  position = 0;
+  finished = false;
+  barrier.reset(l1.size());
+
+  std::vector<std::thread> threads;
+  for(uint32_t i=0; i<l1.size(); i++)
+    threads.push_back(std::thread(deterministic ? &ThreadedHierarchy::run_ordered : &ThreadedHierarchy::run_free, this, i));
+  for(auto &t : threads) t.join();
+  return rv;
+}
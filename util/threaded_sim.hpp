@@ -0,0 +1,80 @@
+#ifndef UTIL_THREADED_SIM_HPP_
+#define UTIL_THREADED_SIM_HPP_
+
+#include "util/trace.hpp"
+#include <pthread.h>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class CoherentCache;
+class L1CacheBase;
+
+// Multi-core simulation of a coherent hierarchy with one thread per core (L1), with coarse locking.
+//   Lock granularity: the whole hierarchy is guarded by a single reader-writer lock. There are no
+//   per-slice or per-set LLC locks: an LLC access probes the L1s of other cores, its victim probes all
+//   of them and the L1 victim writes back to another slice, so the locks an access needs are only known
+//   once the replacers have picked the victims. Parallel speedup has not been measured.
+//   An access served by the core's own L1 alone (a read hit, or a write hit to a modified line)
+//   runs under the shared lock, so L1 hits of different cores proceed in parallel. All other
+//   accesses (misses, upgrades and flushes, hence every LLC access and coherence probe) take the
+//   exclusive lock. The reporter is per thread, so while the calling thread records events (any tracer
+//   or monitor registered) the trace is replayed in order on the calling thread instead.
+//
+//   The deterministic mode orders the accesses by their global timestamp (position in the trace)
+//   and gives the same result as a sequential replay. It runs in rounds: every core finds its first
+//   access that is not L1-local, the L1-local accesses before the earliest of them run in parallel,
+//   then the following accesses run one by one in timestamp order until a run of L1-local ones.
+class ThreadedHierarchy
+{
+public:
+  struct Counters {
+    uint64_t access, miss, local;   // local: accesses served by the L1 alone while other cores run
+    char pad[40];                   // a cache line per core
+    Counters() : access(0), miss(0), local(0) {}
+  };
+
+private:
+  class Barrier {
+    std::mutex mtx;
+    std::condition_variable cv;
+    uint32_t count, waiting, generation;
+  public:
+    Barrier() : count(0), waiting(0), generation(0) {}
+    void reset(uint32_t n) { count = n; waiting = 0; }
+    void wait();
+  };
+
+  std::vector<L1CacheBase *> l1;
+  pthread_rwlock_t lock;
+  std::vector<Counters> counters;
+
+  // the trace being replayed
+  const TraceRecord *records;
+  size_t n;
+  std::vector<std::vector<size_t> > lists;  // positions of the records of every core
+
+  // deterministic mode
+  std::vector<size_t> cursors;
+  std::atomic<size_t> earliest;             // the earliest access not L1-local found in this round
+  size_t position;                          // all records before it have been simulated
+  bool finished;
+  Barrier barrier;
+
+  bool valid(const TraceRecord &r) const { return r.core < l1.size() && r.op <= TraceRecord::FLUSH; }
+  bool local(const TraceRecord &r) const;
+  void exec(const TraceRecord &r, bool local);
+  void serial(size_t from);
+  void run_free(uint32_t core);
+  void run_ordered(uint32_t core);
+
+public:
+  ThreadedHierarchy(const std::vector<CoherentCache *> &l1_caches);
+  ~ThreadedHierarchy();
+
+  // replay a trace with one thread per core, return the number of replayed records
+  uint64_t replay(const TraceRecord *records, size_t n, bool deterministic = false);
+  const Counters &get_counters(uint32_t core) const { return counters[core]; }
+};
+
+#endif
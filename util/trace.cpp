@@ -0,0 +1,57 @@
+#include "util/trace.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char trace_magic[8] = {'C', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+
+bool TraceFile::open(const std::string &fn) {
+  close();
+  fd = ::open(fn.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(fstat(fd, &st) || st.st_size < 16) { close(); return false; }
+  len = st.st_size;
+  base = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(base == MAP_FAILED) { base = NULL; close(); return false; }
+  if(memcmp(base, trace_magic, sizeof(trace_magic))) { close(); return false; }
+  // advice values are not flags, each needs its own call
+  madvise(base, len, MADV_SEQUENTIAL);
+  madvise(base, len, MADV_WILLNEED);
+  return true;
+}
+
+void TraceFile::close() {
+  if(base) munmap(base, len);
+  if(fd >= 0) ::close(fd);
+  base = NULL;
+  fd = -1;
+  len = 0;
+}
+
+bool TraceWriter::open(const std::string &fn) {
+  close();
+  fp = fopen(fn.c_str(), "wb");
+  if(!fp) return false;
+  char header[16] = {0};
+  memcpy(header, trace_magic, sizeof(trace_magic));
+  fwrite(header, sizeof(header), 1, fp);
+  buf.reserve(4096);
+  return true;
+}
+
+void TraceWriter::flush() {
+  if(fp && !buf.empty()) fwrite(buf.data(), sizeof(TraceRecord), buf.size(), fp);
+  buf.clear();
+}
+
+bool TraceWriter::close() {
+  if(!fp) return true;
+  flush();
+  bool rv = !ferror(fp);
+  rv = fclose(fp) == 0 && rv;
+  fp = NULL;
+  return rv;
+}
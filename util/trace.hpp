@@ -0,0 +1,55 @@
+#ifndef UTIL_TRACE_HPP_
+#define UTIL_TRACE_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// a memory access of a binary trace
+//   a trace file is a 16-byte header ("CMTRACE1" and 8 reserved bytes) followed by the records
+struct TraceRecord {
+  enum { READ = 0, WRITE = 1, FLUSH = 2 };
+  uint64_t addr;
+  uint16_t core;
+  uint8_t  op;
+  uint8_t  pad[5];
+};
+
+static_assert(sizeof(TraceRecord) == 16, "unexpected size of TraceRecord");
+
+// read-only memory map of a trace file
+class TraceFile
+{
+  int fd;
+  void *base;
+  size_t len;
+public:
+  TraceFile() : fd(-1), base(NULL), len(0) {}
+  ~TraceFile() { close(); }
+  bool open(const std::string &fn);
+  void close();
+  const TraceRecord *data() const { return (const TraceRecord *)((const char *)base + 16); }
+  size_t size() const { return base ? (len - 16) / sizeof(TraceRecord) : 0; }
+};
+
+// buffered trace writer
+class TraceWriter
+{
+  FILE *fp;
+  std::vector<TraceRecord> buf;
+public:
+  TraceWriter() : fp(NULL) {}
+  ~TraceWriter() { close(); }
+  bool open(const std::string &fn);
+  bool close();   // false when the trace could not be written completely
+  void flush();
+  void write(uint16_t core, uint8_t op, uint64_t addr) {
+    TraceRecord r = {addr, core, op, {0, 0, 0, 0, 0}};
+    buf.push_back(r);
+    if(buf.size() == 4096) flush();
+  }
+};
+
+#endif
@@ -0,0 +1,258 @@
+#include "util/trace_delta.hpp"
+#include "util/stream.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char delta_magic[8] = {'C', 'M', 'D', 'E', 'L', 'T', 'A', '1'};
+static const char index_magic[8] = {'C', 'M', 'D', 'I', 'N', 'D', 'E', 'X'};
+static const uint32_t block_marker = 0x4b4c4243; // "CBLK"
+
+static inline uint64_t zigzag(int64_t v)    { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static inline int64_t  unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+// varint decoding with a fast path for the common 1 and 2-byte tokens,
+// false for a token truncated by `end' or longer than 64 bits
+static inline bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+  if(p == end) return false;
+  v = p[0];
+  if(!(v & 0x80)) { p += 1; return true; }
+  if(end - p < 2) return false;
+  v = (v & 0x7f) | ((uint64_t)p[1] << 7);
+  if(!(p[1] & 0x80)) { p += 2; return true; }
+  v &= 0x3fff;
+  p += 2;
+  for(uint32_t shift = 14; p < end && shift <= 63; shift += 7) {
+    v |= (uint64_t)(*p & 0x7f) << shift;
+    if(!(*(p++) & 0x80)) return true;
+  }
+  return false;
+}
+
+uint32_t delta_decode_block(const uint8_t *p, size_t bytes, TraceRecord *out, uint32_t records, uint32_t shift) {
+  const uint8_t *end = p + bytes;
+  std::vector<uint64_t> prev(1, 0);
+  uint16_t core = 0;
+  TraceRecord last = {0, 0, 0, {0, 0, 0, 0, 0}};
+  uint32_t n = 0;
+  uint64_t v, c;
+  while(n < records && p < end) {
+    if(!get_varint(p, end, v)) break;
+    uint8_t op = v & 0x3;
+    if(op == 3) {                    // run of repeats
+      for(uint64_t r = v >> 2; r > 0 && n < records; r--) out[n++] = last;
+      continue;
+    }
+    if(v & 0x4) {
+      if(!get_varint(p, end, c) || c > UINT16_MAX) break;
+      core = c;
+      if(core >= prev.size()) prev.resize(core+1, 0);
+    }
+    prev[core] += unzigzag(v >> 3);
+    last.addr = prev[core] << shift;
+    last.core = core;
+    last.op = op;
+    out[n++] = last;
+  }
+  return n;
+}
+
+/////////////////////////////////
+// writer
+
+void DeltaTraceWriter::put(uint64_t v) {
+  while(v >= 0x80) {
+    payload.push_back((v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  payload.push_back(v);
+}
+
+bool DeltaTraceWriter::open(const std::string &fn, const std::string &compress, bool byte_addr) {
+  close();
+  fp = open_stream(fn, true, &piped, compress);
+  if(!fp) return false;
+  uint32_t flags = byte_addr ? DELTA_BYTE_ADDR : 0;
+  shift = byte_addr ? 0 : 6;
+  char header[16] = {0};
+  memcpy(header, delta_magic, sizeof(delta_magic));
+  memcpy(header + 8, &block_records, sizeof(block_records));
+  memcpy(header + 12, &flags, sizeof(flags));
+  fwrite(header, sizeof(header), 1, fp);
+  offset = sizeof(header);
+  total = 0;
+  records = 0;
+  run = 0;
+  index.clear();
+  payload.clear();
+  prev.assign(1, 0);
+  core = 0;
+  return true;
+}
+
+void DeltaTraceWriter::flush_run() {
+  if(run) put((run << 2) | 3);
+  run = 0;
+}
+
+void DeltaTraceWriter::flush_block() {
+  flush_run();
+  if(!records) return;
+  DeltaBlockHeader h = {block_marker, (uint32_t)payload.size(), records, 0, total};
+  fwrite(&h, sizeof(h), 1, fp);
+  fwrite(payload.data(), 1, payload.size(), fp);
+  index.push_back(std::make_pair(offset, total));
+  offset += sizeof(h) + payload.size();
+  total += records;
+  records = 0;
+  payload.clear();
+  prev.assign(1, 0);   // reset the predictors
+  core = 0;
+}
+
+void DeltaTraceWriter::write(uint16_t c, uint8_t op, uint64_t addr) {
+  uint64_t line = addr >> shift;   // the byte address with DELTA_BYTE_ADDR
+  if(records && run < UINT32_MAX && c == last.core && op == last.op && line == last.addr) {
+    run++;
+  } else {
+    flush_run();
+    uint64_t v = op;
+    if(c != core) {
+      v |= 0x4;
+      core = c;
+      if(core >= prev.size()) prev.resize(core+1, 0);
+    }
+    put((zigzag(line - prev[core]) << 3) | v);
+    if(v & 0x4) put(core);
+    prev[core] = line;
+    last.core = c; last.op = op; last.addr = line;
+  }
+  if(++records == block_records) flush_block();
+}
+
+bool DeltaTraceWriter::close() {
+  if(!fp) return true;
+  flush_block();
+  for(auto &i : index) {
+    fwrite(&i.first, sizeof(uint64_t), 1, fp);
+    fwrite(&i.second, sizeof(uint64_t), 1, fp);
+  }
+  uint64_t n = index.size();
+  fwrite(&n, sizeof(n), 1, fp);
+  fwrite(&total, sizeof(total), 1, fp);
+  fwrite(index_magic, sizeof(index_magic), 1, fp);
+  bool rv = close_stream(fp, piped);
+  fp = NULL;
+  return rv;
+}
+
+/////////////////////////////////
+// random-access reader
+
+bool DeltaTraceFile::open(const std::string &fn) {
+  close();
+  fd = ::open(fn.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat st;
+  if(fstat(fd, &st) || st.st_size < 40) { close(); return false; }
+  len = st.st_size;
+  void *m = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(m == MAP_FAILED) { close(); return false; }
+  base = (const uint8_t *)m;
+  madvise(m, len, MADV_SEQUENTIAL);
+  uint32_t flags;
+  memcpy(&block_records, base + 8, 4);
+  memcpy(&flags, base + 12, 4);
+  shift = (flags & DELTA_BYTE_ADDR) ? 0 : 6;
+
+  // a corrupt file must fail here: check the index and every block header against the file size
+  const uint8_t *tail = base + len - 24;
+  uint64_t nblock;
+  memcpy(&nblock, tail, 8);
+  memcpy(&total, tail + 8, 8);
+  if(memcmp(base, delta_magic, 8) || memcmp(tail + 16, index_magic, 8) || nblock > (len - 40) / 16) { close(); return false; }
+  const uint8_t *ip = tail - nblock * 16;
+  uint64_t limit = ip - base;         // blocks end before the index
+  index.resize(nblock);
+  for(uint64_t i=0; i<nblock; i++) {
+    memcpy(&index[i].first,  ip + 16*i,     8);
+    memcpy(&index[i].second, ip + 16*i + 8, 8);
+    DeltaBlockHeader h;
+    uint64_t offset = index[i].first;
+    if(offset < 16 || offset > limit || limit - offset < sizeof(h)) { close(); return false; }
+    memcpy(&h, base + offset, sizeof(h));
+    if(h.marker != block_marker || h.bytes > limit - offset - sizeof(h) ||
+       h.records > block_records || h.first != index[i].second) { close(); return false; }
+  }
+  next_block = 0;
+  return true;
+}
+
+void DeltaTraceFile::close() {
+  if(base) munmap((void *)base, len);
+  if(fd >= 0) ::close(fd);
+  base = NULL;
+  fd = -1;
+  len = 0;
+  total = 0;
+  index.clear();
+}
+
+uint64_t DeltaTraceFile::seek(uint64_t i) {
+  size_t lo = 0, hi = index.size();    // the last block starting at or before `i'
+  while(hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if(index[mid].second <= i) lo = mid; else hi = mid;
+  }
+  next_block = lo;
+  return index.empty() ? 0 : index[lo].second;
+}
+
+bool DeltaTraceFile::next(std::vector<TraceRecord> &out) {
+  if(next_block >= index.size()) return false;
+  DeltaBlockHeader h;
+  memcpy(&h, base + index[next_block].first, sizeof(h));
+  out.resize(h.records);
+  uint32_t n = delta_decode_block(base + index[next_block].first + sizeof(h), h.bytes, out.data(), h.records, shift);
+  next_block++;
+  if(n < h.records) { out.resize(n); return false; } // corrupt payload
+  return true;
+}
+
+/////////////////////////////////
+// stream decoder
+
+size_t DeltaDecoder::decode(FILE *fp, TraceRecord *out, size_t max) {
+  if(!header) {
+    char h[16];
+    if(fread(h, sizeof(h), 1, fp) != 1 || memcmp(h, delta_magic, 8)) return 0;
+    uint32_t flags;
+    memcpy(&block_records, h + 8, 4);
+    memcpy(&flags, h + 12, 4);
+    shift = (flags & DELTA_BYTE_ADDR) ? 0 : 6;
+    header = true;
+  }
+  size_t n = 0;
+  while(n < max) {
+    if(pos == block.size()) {
+      if(corrupt) break;
+      DeltaBlockHeader h;
+      if(fread(&h, sizeof(h), 1, fp) != 1 || h.marker != block_marker) break; // reached the footer
+      // a token takes at most 13 bytes (a 64-bit delta and a 16-bit core), bound the buffers before sizing them
+      if(h.records > block_records || h.bytes > 13 * (uint64_t)h.records) break;
+      payload.resize(h.bytes);
+      if(fread(payload.data(), 1, h.bytes, fp) != h.bytes) break;
+      block.resize(h.records);
+      block.resize(delta_decode_block(payload.data(), h.bytes, block.data(), h.records, shift));
+      pos = 0;
+      corrupt = block.size() < h.records;  // end the trace after the records decoded so far
+    }
+    size_t m = std::min(max - n, block.size() - pos);
+    memcpy(out + n, block.data() + pos, m * sizeof(TraceRecord));
+    n += m;
+    pos += m;
+  }
+  return n;
+}
@@ -0,0 +1,113 @@
+#ifndef UTIL_TRACE_DELTA_HPP_
+#define UTIL_TRACE_DELTA_HPP_
+
+#include "util/trace.hpp"
+#include "util/trace_import.hpp"
+#include "util/report.hpp"
+
+// Compact trace format
+//   header: "CMDELTA1", uint32 records per block, uint32 flags
+//   blocks: a 24-byte header (marker "CBLK", payload bytes, records, reserved, index of the first record)
+//           followed by the payload
+//   footer: (file offset, first record) of every block, the number of blocks,
+//           the number of records and "CMDINDEX", all 64-bit
+// Addresses are kept at cache line granularity by default, as the cache model normalizes them anyway,
+// so the offset within the line is lost. With DELTA_BYTE_ADDR set in the flags they are kept in full.
+// Every record is a varint token: op in [1:0] (3 for a run of repeats of the previous record),
+// a core switch flag in [2] followed by the core as another varint, and the zigzag delta of
+// the (line) address to the previous address of the same core in [63:3] (the run length for repeats).
+// The predictors are reset at every block, so blocks decode independently for random seek.
+
+#define DELTA_BYTE_ADDR 0x1u
+
+struct DeltaBlockHeader {
+  uint32_t marker;
+  uint32_t bytes;
+  uint32_t records;
+  uint32_t reserved;
+  uint64_t first;
+};
+
+// decode a block payload into `records' trace records, `shift': 6 for line addresses, 0 for byte addresses,
+// return the number of records decoded, fewer than `records' for a corrupt payload
+extern uint32_t delta_decode_block(const uint8_t *payload, size_t bytes, TraceRecord *out, uint32_t records, uint32_t shift);
+
+class DeltaTraceWriter
+{
+  FILE *fp;
+  bool piped;
+  uint32_t block_records;
+  uint32_t shift;                 // of the stored addresses
+  std::vector<uint8_t> payload;
+  uint32_t records;               // records in the current block
+  uint64_t total;                 // records in the file
+  uint64_t offset;                // file offset of the current block
+  std::vector<std::pair<uint64_t, uint64_t> > index;
+
+  std::vector<uint64_t> prev;     // previous stored address of every core
+  uint16_t core;
+  TraceRecord last;
+  uint64_t run;                   // pending repeats of `last'
+
+  void put(uint64_t v);
+  void flush_run();
+  void flush_block();
+
+public:
+  DeltaTraceWriter(uint32_t block_records = 1 << 16) : fp(NULL), piped(false), block_records(block_records), shift(6) {}
+  ~DeltaTraceWriter() { close(); }
+  // byte_addr: keep the offset within the line (DELTA_BYTE_ADDR), at the cost of larger deltas
+  bool open(const std::string &fn, const std::string &compress = "", bool byte_addr = false);
+  bool close();   // false when the trace could not be written completely
+  void write(uint16_t core, uint8_t op, uint64_t addr);
+};
+
+// random-access reader of an uncompressed compact trace through a memory map
+class DeltaTraceFile
+{
+  int fd;
+  const uint8_t *base;
+  size_t len;
+  std::vector<std::pair<uint64_t, uint64_t> > index;
+  uint64_t total;
+  uint32_t block_records;
+  uint32_t shift;
+  size_t next_block;
+public:
+  DeltaTraceFile() : fd(-1), base(NULL), len(0), total(0), block_records(0), shift(6), next_block(0) {}
+  ~DeltaTraceFile() { close(); }
+  bool open(const std::string &fn);   // false also for a file with an inconsistent index
+  void close();
+  uint64_t size() const { return total; }
+  // position at the block containing record `i', return the index of the first record of that block
+  uint64_t seek(uint64_t i);
+  // decode the next block into `out' (resized as needed), return false at the end or for a corrupt block
+  bool next(std::vector<TraceRecord> &out);
+};
+
+// sequential decoder for TraceStream, compressed files are supported
+class DeltaDecoder : public TraceDecoder
+{
+  bool header;
+  bool corrupt;                   // the current block is cut short, nothing follows it
+  uint32_t block_records;
+  uint32_t shift;
+  std::vector<uint8_t> payload;
+  std::vector<TraceRecord> block;
+  size_t pos;
+public:
+  DeltaDecoder() : header(false), corrupt(false), block_records(0), shift(6), pos(0) {}
+  virtual size_t decode(FILE *fp, TraceRecord *out, size_t max);
+};
+
+// record the requests of cores to their L1 caches, attached to the reporter as an access monitor
+class TraceRecorder : public AccessMonitor
+{
+  DeltaTraceWriter *writer;
+public:
+  TraceRecorder(DeltaTraceWriter *writer) : writer(writer) {}
+  virtual void request(int32_t core_id, uint32_t op, uint64_t addr) { writer->write(core_id, op, addr); }
+  virtual void access(uint32_t level, int32_t core_id, int32_t cache_id, uint64_t addr, uint32_t idx, uint32_t way, bool hit) {}
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "util/trace_import.hpp"
+#include "util/trace_delta.hpp"
+#include "util/stream.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+TraceDecoder *TraceDecoder::factory(const std::string &format, uint16_t core) {
+  if(format == "native")   return new NativeDecoder();
+  if(format == "champsim") return new ChampSimDecoder(core);
+  if(format == "pin")      return new PinDecoder(core);
+  if(format == "spike")    return new SpikeDecoder();
+  if(format == "delta")    return new DeltaDecoder();
+  return NULL;
+}
+
+size_t NativeDecoder::decode(FILE *fp, TraceRecord *out, size_t max) {
+  if(!header) {
+    char h[16];
+    if(fread(h, sizeof(h), 1, fp) != 1 || memcmp(h, "CMTRACE1", 8)) return 0;
+    header = true;
+  }
+  return fread(out, sizeof(TraceRecord), max, fp);
+}
+
+size_t ChampSimDecoder::decode(FILE *fp, TraceRecord *out, size_t max) {
+  struct {
+    uint64_t ip;
+    uint8_t  is_branch, branch_taken;
+    uint8_t  dst_reg[2], src_reg[4];
+    uint64_t dst_mem[2], src_mem[4];
+  } instr;
+  static_assert(sizeof(instr) == 64, "unexpected size of ChampSim instructions");
+
+  size_t n = 0;
+  while(n + 6 <= max && fread(&instr, sizeof(instr), 1, fp) == 1) {
+    for(auto a : instr.src_mem) if(a) out[n++] = {a, core, TraceRecord::READ,  {0, 0, 0, 0, 0}};
+    for(auto a : instr.dst_mem) if(a) out[n++] = {a, core, TraceRecord::WRITE, {0, 0, 0, 0, 0}};
+  }
+  return n;
+}
+
+size_t PinDecoder::decode(FILE *fp, TraceRecord *out, size_t max) {
+  char line[256];
+  size_t n = 0;
+  while(n < max && fgets(line, sizeof(line), fp)) {
+    char *p = strchr(line, ':');
+    if(line[0] == '#' || !p) continue;
+    while(*(++p) == ' ');
+    uint8_t op;
+    if(*p == 'R')      op = TraceRecord::READ;
+    else if(*p == 'W') op = TraceRecord::WRITE;
+    else continue;
+    out[n++] = {strtoull(p+1, NULL, 16), core, op, {0, 0, 0, 0, 0}};
+  }
+  return n;
+}
+
+size_t SpikeDecoder::decode(FILE *fp, TraceRecord *out, size_t max) {
+  char line[512];
+  size_t n = 0;
+  while(n < max && fgets(line, sizeof(line), fp)) {
+    char *p = strstr(line, " mem ");
+    if(strncmp(line, "core", 4) || !p) continue;
+    uint16_t core = strtoul(line + 4, NULL, 10);
+    char *end;
+    uint64_t addr = strtoull(p + 5, &end, 16);
+    while(*end == ' ') end++;
+    bool store = *end != '\n' && *end != '\0';  // a store logs the data after the address
+    out[n++] = {addr, core, (uint8_t)(store ? TraceRecord::WRITE : TraceRecord::READ), {0, 0, 0, 0, 0}};
+  }
+  return n;
+}
+
+TraceStream::TraceStream(uint32_t nbatch, size_t batch_size)
+  : fp(NULL), piped(false), batches(nbatch, std::vector<TraceRecord>(batch_size)), sizes(nbatch, 0),
+    full(nbatch), free(nbatch), stop(false), done(true), current(-1) {}
+
+bool TraceStream::open(const std::string &fn, const std::string &format, uint16_t core) {
+  close();
+  decoder.reset(TraceDecoder::factory(format, core));
+  if(!decoder) return false;
+  fp = open_stream(fn, false, &piped);
+  if(!fp) return false;
+  uint32_t i;
+  while(full.pop(i));
+  while(free.pop(i));
+  for(i=0; i<batches.size(); i++) free.push(i);
+  stop = false;
+  done = false;
+  current = -1;
+  reader = std::thread(&TraceStream::read_loop, this);
+  return true;
+}
+
+void TraceStream::read_loop() {
+  uint32_t i, backoff = 10;
+  while(!stop) {
+    if(!free.pop(i)) {  // the consumer is behind, back off up to 2ms
+      std::this_thread::sleep_for(std::chrono::microseconds(backoff));
+      backoff = std::min(backoff * 2, 2000u);
+      continue;
+    }
+    backoff = 10;
+    sizes[i] = decoder->decode(fp, batches[i].data(), batches[i].size());
+    if(sizes[i] == 0) break;
+    full.push(i);
+  }
+  done = true;
+}
+
+bool TraceStream::next(const TraceRecord **records, size_t *n) {
+  if(current >= 0) free.push(current);
+  current = -1;
+  uint32_t i;
+  while(!full.pop(i)) {
+    if(done && full.empty()) return false; // the reader pushes its last batch before setting done
+    std::this_thread::yield();
+  }
+  current = i;
+  *records = batches[i].data();
+  *n = sizes[i];
+  return true;
+}
+
+void TraceStream::close() {
+  if(!fp) return;
+  stop = true;
+  reader.join();
+  close_stream(fp, piped);
+  fp = NULL;
+  done = true;
+}
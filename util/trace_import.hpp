@@ -0,0 +1,84 @@
+#ifndef UTIL_TRACE_IMPORT_HPP_
+#define UTIL_TRACE_IMPORT_HPP_
+
+#include "util/trace.hpp"
+#include "util/ring.hpp"
+#include <thread>
+#include <atomic>
+#include <memory>
+
+// decode a stream of a trace format into trace records
+class TraceDecoder
+{
+public:
+  // decode up to `max' records, return 0 at the end of the stream
+  virtual size_t decode(FILE *fp, TraceRecord *out, size_t max) = 0;
+  virtual ~TraceDecoder() {}
+
+  // "native", "delta" (util/trace_delta.hpp), "champsim", "pin" or "spike"; return NULL for unknown formats
+  static TraceDecoder *factory(const std::string &format, uint16_t core = 0);
+};
+
+// native trace files (see util/trace.hpp)
+class NativeDecoder : public TraceDecoder
+{
+  bool header;
+public:
+  NativeDecoder() : header(false) {}
+  virtual size_t decode(FILE *fp, TraceRecord *out, size_t max);
+};
+
+// ChampSim binary traces: 64-byte instructions with up to 4 source and 2 destination memory operands
+class ChampSimDecoder : public TraceDecoder
+{
+  uint16_t core;
+public:
+  ChampSimDecoder(uint16_t core) : core(core) {}
+  virtual size_t decode(FILE *fp, TraceRecord *out, size_t max);
+};
+
+// Pin memory traces (pinatrace): "<ip>: <R|W> <addr>" per line
+class PinDecoder : public TraceDecoder
+{
+  uint16_t core;
+public:
+  PinDecoder(uint16_t core) : core(core) {}
+  virtual size_t decode(FILE *fp, TraceRecord *out, size_t max);
+};
+
+// Spike commit logs (--log-commits): "core N: ... mem <addr>" for loads
+// and "core N: ... mem <addr> <data>" for stores
+class SpikeDecoder : public TraceDecoder
+{
+public:
+  virtual size_t decode(FILE *fp, TraceRecord *out, size_t max);
+};
+
+// Pipelined trace reader: a thread decompresses (by file extension, see util/stream.hpp)
+// and decodes the trace into a fixed pool of batches, handed over through lock-free rings,
+// so decoding overlaps simulation and the trace is never held in memory as a whole.
+class TraceStream
+{
+  std::unique_ptr<TraceDecoder> decoder;
+  FILE *fp;
+  bool piped;
+  std::vector<std::vector<TraceRecord> > batches;
+  std::vector<size_t> sizes;
+  SPSCRing<uint32_t> full, free;  // batch indices
+  std::thread reader;
+  std::atomic<bool> stop;
+  std::atomic<bool> done;
+  int32_t current;                // the batch held by the consumer, -1 if none
+
+  void read_loop();
+
+public:
+  TraceStream(uint32_t nbatch = 4, size_t batch_size = 1 << 14);
+  ~TraceStream() { close(); }
+  bool open(const std::string &fn, const std::string &format, uint16_t core = 0);
+  void close();
+  // get the next batch of records, the previous batch is released; return false at the end
+  bool next(const TraceRecord **records, size_t *n);
+};
+
+#endif
@@ -27,21 +27,28 @@ void traverse_config_decoder(TraverseTestCFG *tcfg, const json &db, const std::s
   traverse_cfg_decode(window,        uint32_t);
   traverse_cfg_decode(repeat,        uint32_t);
   traverse_cfg_decode(step,          uint32_t);
+  traverse_cfg_decode(seed,          uint64_t);
+  traverse_cfg_decode(page_size,     uint64_t);
+  traverse_cfg_decode(page_map,      std::string);
+  traverse_cfg_decode(rollback,      bool);
   traverse_cfg_decode(traverse_type, std::string);
 }
 
-traverse_func_t traverse_config_parser(const std::string& fn, const std::string& cfg, TraverseTestCFG *tcfg) {
-  json db;
+static bool traverse_config_load(const std::string& fn, json *db) {
   std::ifstream db_file(fn);
   if(db_file.good()) {
-    db_file >> db;
+    db_file >> *db;
     db_file.close();
-    // std::cout << db.dump(4) << std::endl;
+    // std::cout << db->dump(4) << std::endl;
+    return true;
   } else {
     std::cerr << "Fail to open config file " << fn << std::endl;
-    return list_traverse(1,1);
+    return false;
   }
+}
 
+static traverse_func_t traverse_config_decode(const json &db, const std::string& cfg, TraverseTestCFG *tcfg, bool *ok) {
+  *ok = false;
   if(!db.count("config") || !db["config"].count(cfg)) {
     std::cerr << boost::format("Fail to find the specific config `%1%'. ") % cfg << std::endl;
     return list_traverse(1,1);
@@ -56,11 +63,33 @@ traverse_func_t traverse_config_parser(const std::string& fn, const std::string&
 
   traverse_config_decoder(tcfg, db, ttype, 0);
 
+  *ok = true;
   if(tcfg->traverse_type == "list")      return list_traverse(tcfg->window, tcfg->repeat);
   if(tcfg->traverse_type == "strategy")  return strategy_traverse(tcfg->window, tcfg->repeat, tcfg->step);
   if(tcfg->traverse_type == "round")     return round_traverse(tcfg->repeat);
 
   // should not reach here
+  *ok = false;
   std::cerr << boost::format("Wrong traverse type `%1%'. ") % tcfg->traverse_type << std::endl;
   return list_traverse(1,1);
 }
+
+traverse_func_t traverse_config_parser(const std::string& fn, const std::string& cfg, TraverseTestCFG *tcfg) {
+  json db;
+  bool ok;
+  if(!traverse_config_load(fn, &db)) return list_traverse(1,1);
+  return traverse_config_decode(db, cfg, tcfg, &ok);
+}
+
+bool traverse_config_parser(const std::string& fn, const std::vector<std::string>& cfgs, std::vector<TraverseTestCFG> *tcfgs, std::vector<traverse_func_t> *funcs) {
+  json db;
+  if(!traverse_config_load(fn, &db)) return false;
+  tcfgs->resize(cfgs.size());
+  funcs->resize(cfgs.size());
+  for(size_t i=0; i<cfgs.size(); i++) {
+    bool ok;
+    (*funcs)[i] = traverse_config_decode(db, cfgs[i], &(*tcfgs)[i], &ok);
+    if(!ok) return false;
+  }
+  return true;
+}
@@ -3,6 +3,7 @@
 
 #include "attack/traverse.hpp"
 #include <string>
+#include <vector>
 struct TraverseTestCFG {
   std::string traverse_type;
   uint32_t ntests;
@@ -11,8 +12,14 @@ struct TraverseTestCFG {
   uint32_t window;
   uint32_t repeat;
   uint32_t step;
+  uint64_t seed;
+  uint64_t page_size;       // 0 for candidates drawn from the whole address space
+  std::string page_map;     // random or linear
+  bool rollback;            // trim from a checkpointed hierarchy state
 };
 
 extern traverse_func_t traverse_config_parser(const std::string& fn, const std::string& cfg, TraverseTestCFG *tcfg);
+// decode multiple configs with a single read of the config file
+extern bool traverse_config_parser(const std::string& fn, const std::vector<std::string>& cfgs, std::vector<TraverseTestCFG> *tcfgs, std::vector<traverse_func_t> *funcs);
 
 #endif